@@ -0,0 +1,311 @@
+/*
+* Host-side microbenchmark for the frame allocator.
+*
+* Compares the buddy frame allocator in data_structures/frame_table.c against the char-per-frame
+* bytemap scan it replaced (reproduced below). Each physical memory size is run with the table
+* mostly full of long-lived frames, since that is where the scan hurts: every allocation walks past
+* the used frames, and every brk-style request counts the whole table first.
+*
+*   churn -- repeatedly free a random live frame and allocate a new one (fork/exec/stack growth)
+*   brk   -- check the free count, allocate BRK_PAGES frames, then free them again (handle_Brk)
+*
+* The buddy allocator is then run on its own under a random mix of block sizes, timing single-frame
+* against whole-run allocation, printing its statistics, and checking that freeing everything merges
+* memory back into the blocks it started with.
+*
+* Build and run with `make run` in this directory.
+*/
+#include <ykernel.h>
+#include <time.h>
+#include "data_structures/frame_table.h"
+
+#define FILL_PERCENT 90                        // how full the table is kept during the runs
+#define CHURN_OPS 200000
+#define BRK_ROUNDS 20000
+#define BRK_PAGES 8
+#define MIX_OPS 200000
+#define MIX_MAX_ORDER 4                        // largest block the random mix asks for
+
+//============================ OLD BYTEMAP ALLOCATOR ==============================//
+/*
+* The bytemap allocator from before the free list: 1 is used, 0 is free
+*/
+static int bytemap_num_free_frames(char *frame_table, int frame_table_size) {
+  int numfree = 0;
+  for (int i=0; i<frame_table_size; i++) {
+    numfree += (frame_table[i] ? 0 : 1);
+  }
+  return numfree;
+}
+
+static int bytemap_get_free_frame(char *frame_table, int frame_table_size, int iterator_start) {
+  for (int i = iterator_start; i < frame_table_size; i++) {
+    if (frame_table[i] == 0) {
+      frame_table[i] = 1;
+      return i;
+    }
+  }
+  return MEMFULL;
+}
+
+static void bytemap_free_frame(char *frame_table, int frame_table_size, int frame_num) {
+  if (frame_num < frame_table_size) {
+    frame_table[frame_num] = 0;
+  }
+}
+
+//============================ BENCHMARK HELPERS ==============================//
+static double now_ns() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/*
+* Exits if an allocator handed out a frame that is already live
+*/
+static void check_frame(char *live, int frame_num, char *who) {
+  if (frame_num == MEMFULL || live[frame_num]) {
+    fprintf(stderr, "%s: bad frame %d handed out\n", who, frame_num);
+    exit(1);
+  }
+  live[frame_num] = 1;
+}
+
+/*
+* Runs both workloads against the bytemap allocator
+*/
+static void bench_bytemap(int num_frames, double *churn_ns, double *brk_ns) {
+  char *frame_table = calloc(num_frames, 1);
+  char *live = calloc(num_frames, 1);
+  int *held = malloc(sizeof(int) * num_frames);
+  int num_held = num_frames * FILL_PERCENT / 100;
+  for (int i=0; i<num_held; i++) {
+    held[i] = bytemap_get_free_frame(frame_table, num_frames, 0);
+    check_frame(live, held[i], "bytemap");
+  }
+
+  srand(58);
+  double start = now_ns();
+  for (int i=0; i<CHURN_OPS; i++) {
+    int victim = rand() % num_held;
+    bytemap_free_frame(frame_table, num_frames, held[victim]);
+    live[held[victim]] = 0;
+    held[victim] = bytemap_get_free_frame(frame_table, num_frames, 0);
+    check_frame(live, held[victim], "bytemap");
+  }
+  *churn_ns = (now_ns() - start) / CHURN_OPS;
+
+  int brk_frames[BRK_PAGES];
+  start = now_ns();
+  for (int i=0; i<BRK_ROUNDS; i++) {
+    if (bytemap_num_free_frames(frame_table, num_frames) < BRK_PAGES) {
+      fprintf(stderr, "bytemap: ran out of frames\n");
+      exit(1);
+    }
+    // the old callers threaded the last frame found through as the next scan start
+    int next_start = 0;
+    for (int j=0; j<BRK_PAGES; j++) {
+      brk_frames[j] = bytemap_get_free_frame(frame_table, num_frames, next_start);
+      check_frame(live, brk_frames[j], "bytemap");
+      next_start = brk_frames[j];
+    }
+    for (int j=0; j<BRK_PAGES; j++) {
+      bytemap_free_frame(frame_table, num_frames, brk_frames[j]);
+      live[brk_frames[j]] = 0;
+    }
+  }
+  *brk_ns = (now_ns() - start) / BRK_ROUNDS;
+
+  free(frame_table);
+  free(live);
+  free(held);
+}
+
+/*
+* Runs both workloads against the buddy frame table
+*/
+static void bench_buddy(int num_frames, double *churn_ns, double *brk_ns) {
+  frame_table_struct_t *frame_table = create_frame_table(num_frames);
+  char *live = calloc(num_frames, 1);
+  int *held = malloc(sizeof(int) * num_frames);
+  int num_held = num_frames * FILL_PERCENT / 100;
+  for (int i=0; i<num_held; i++) {
+    held[i] = get_free_frame(frame_table, 1);
+    check_frame(live, held[i], "buddy");
+  }
+
+  srand(58);
+  double start = now_ns();
+  for (int i=0; i<CHURN_OPS; i++) {
+    int victim = rand() % num_held;
+    release_frame(frame_table, held[victim]);
+    live[held[victim]] = 0;
+    held[victim] = get_free_frame(frame_table, 1);
+    check_frame(live, held[victim], "buddy");
+  }
+  *churn_ns = (now_ns() - start) / CHURN_OPS;
+
+  int brk_frames[BRK_PAGES];
+  start = now_ns();
+  for (int i=0; i<BRK_ROUNDS; i++) {
+    if (get_num_free_frames(frame_table) < BRK_PAGES) {
+      fprintf(stderr, "buddy: ran out of frames\n");
+      exit(1);
+    }
+    for (int j=0; j<BRK_PAGES; j++) {
+      brk_frames[j] = get_free_frame(frame_table, 1);
+      check_frame(live, brk_frames[j], "buddy");
+    }
+    for (int j=0; j<BRK_PAGES; j++) {
+      release_frame(frame_table, brk_frames[j]);
+      live[brk_frames[j]] = 0;
+    }
+  }
+  *brk_ns = (now_ns() - start) / BRK_ROUNDS;
+
+  if (get_num_free_frames(frame_table) != num_frames - num_held) {
+    fprintf(stderr, "buddy: free count %d, expected %d\n",
+            get_num_free_frames(frame_table), num_frames - num_held);
+    exit(1);
+  }
+  free(frame_table->frames);
+  free(frame_table);
+  free(live);
+  free(held);
+}
+
+/*
+* Random mix of block allocations and frees on a buddy allocator of num_frames frames
+*/
+static void bench_buddy_mix(int num_frames) {
+  frame_table_struct_t *frame_table = create_frame_table(num_frames);
+  frame_stats_t before;
+  get_frame_stats(frame_table, &before);
+  char *live = calloc(num_frames, 1);
+  int *held_head = malloc(sizeof(int) * num_frames);
+  int *held_order = malloc(sizeof(int) * num_frames);
+  int num_held = 0;
+
+  srand(58);
+  double start = now_ns();
+  for (int i=0; i<MIX_OPS; i++) {
+    // grow towards 3/4 full, then hover there
+    if (num_held > 0 && (rand() % 4 == 0 || get_num_free_frames(frame_table) < num_frames / 4)) {
+      int victim = rand() % num_held;
+      for (int j=0; j<(1 << held_order[victim]); j++) {
+        release_frame(frame_table, held_head[victim] + j);
+        live[held_head[victim] + j] = 0;
+      }
+      num_held--;
+      held_head[victim] = held_head[num_held];
+      held_order[victim] = held_order[num_held];
+    }
+    else {
+      int order = rand() % (MIX_MAX_ORDER + 1);
+      int head = alloc_frames(frame_table, order, 1);
+      if (head == MEMFULL) {
+        continue;
+      }
+      for (int j=0; j<(1 << order); j++) {
+        check_frame(live, head + j, "buddy");
+      }
+      held_head[num_held] = head;
+      held_order[num_held] = order;
+      num_held++;
+    }
+  }
+  double mix_ns = (now_ns() - start) / MIX_OPS;
+
+  frame_stats_t stats;
+  get_frame_stats(frame_table, &stats);
+  printf("%10d | %8.1f ns/op, %d allocs, %d failed, %d splits, %d merges, worst alloc %d splits\n",
+         num_frames, mix_ns, stats.num_allocs, stats.num_alloc_failures, stats.num_splits,
+         stats.num_merges, stats.max_alloc_splits);
+  printf("%10s | %d free, largest free order %d, fragmentation at order 0..%d:", "",
+         stats.num_free_frames, stats.largest_free_order, MIX_MAX_ORDER + 2);
+  for (int order=0; order<=MIX_MAX_ORDER + 2; order++) {
+    printf(" %d%%", stats.fragmentation[order]);
+  }
+  printf("\n");
+
+  // with everything freed the buddies should have merged back into the original blocks
+  for (int i=0; i<num_held; i++) {
+    for (int j=0; j<(1 << held_order[i]); j++) {
+      release_frame(frame_table, held_head[i] + j);
+    }
+  }
+  get_frame_stats(frame_table, &stats);
+  for (int order=0; order<=FRAME_MAX_ORDER; order++) {
+    if (stats.free_blocks[order] != before.free_blocks[order]) {
+      fprintf(stderr, "buddy: %d free blocks of order %d after freeing everything, expected %d\n",
+              stats.free_blocks[order], order, before.free_blocks[order]);
+      exit(1);
+    }
+  }
+
+  free(frame_table->frames);
+  free(frame_table);
+  free(live);
+  free(held_head);
+  free(held_order);
+}
+
+/*
+* Time allocating BRK_PAGES frames one at a time against one get_free_frames call
+*/
+static void bench_buddy_runs(int num_frames) {
+  frame_table_struct_t *frame_table = create_frame_table(num_frames);
+  int pfns[BRK_PAGES];
+
+  double start = now_ns();
+  for (int i=0; i<BRK_ROUNDS; i++) {
+    for (int j=0; j<BRK_PAGES; j++) {
+      pfns[j] = get_free_frame(frame_table, 1);
+    }
+    for (int j=0; j<BRK_PAGES; j++) {
+      release_frame(frame_table, pfns[j]);
+    }
+  }
+  double single_ns = (now_ns() - start) / BRK_ROUNDS;
+
+  start = now_ns();
+  for (int i=0; i<BRK_ROUNDS; i++) {
+    get_free_frames(frame_table, BRK_PAGES, 1, pfns);
+    for (int j=0; j<BRK_PAGES; j++) {
+      release_frame(frame_table, pfns[j]);
+    }
+  }
+  double run_ns = (now_ns() - start) / BRK_ROUNDS;
+  printf("%10d | %d frames one at a time %.1f ns, as one run %.1f ns\n", num_frames, BRK_PAGES,
+         single_ns, run_ns);
+
+  free(frame_table->frames);
+  free(frame_table);
+}
+
+int main() {
+  int sizes[] = {512, 4096, 32768, 262144};
+  int num_sizes = sizeof(sizes) / sizeof(sizes[0]);
+
+  printf("frame allocator, table kept %d%% full (ns per operation)\n", FILL_PERCENT);
+  printf("%10s | %14s %14s | %14s %14s\n", "frames", "bytemap churn", "buddy churn",
+         "bytemap brk", "buddy brk");
+  for (int i=0; i<num_sizes; i++) {
+    double bytemap_churn, bytemap_brk, list_churn, list_brk;
+    bench_bytemap(sizes[i], &bytemap_churn, &bytemap_brk);
+    bench_buddy(sizes[i], &list_churn, &list_brk);
+    printf("%10d | %14.1f %14.1f | %14.1f %14.1f\n", sizes[i], bytemap_churn, list_churn,
+           bytemap_brk, list_brk);
+  }
+
+  printf("\nbuddy allocator, random blocks of order 0..%d\n", MIX_MAX_ORDER);
+  for (int i=0; i<num_sizes; i++) {
+    bench_buddy_mix(sizes[i]);
+  }
+  printf("\nbuddy allocator, alloc and free of a %d frame run\n", BRK_PAGES);
+  for (int i=0; i<num_sizes; i++) {
+    bench_buddy_runs(sizes[i]);
+  }
+  return 0;
+}
@@ -0,0 +1,213 @@
+/*
+* Host-side microbenchmark for looking up locks, cvars and pipes by id.
+*
+* Compares the id table in data_structures/id_table.c against the doubly linked list (newest first)
+* that find_lock, find_cvar and find_pipe used to walk, reproduced below. For each object count:
+*
+*   create  -- make that many objects, giving each the next id (LockInit/CvarInit/PipeInit)
+*   find    -- look up random live ids (every Acquire, Release, CvarWait, PipeRead and PipeWrite)
+*   reclaim -- find and unlink every object in a random order (Reclaim)
+*
+* Build and run with `make run` in this directory.
+*/
+#include <ykernel.h>
+#include <time.h>
+#include "data_structures/id_table.h"
+
+#define MIN_ID 2000000                         // the lock id range from kernel_start.c
+#define MAX_ID 3000000
+#define FIND_OPS 200000
+
+typedef struct object {
+  int id;
+  struct object *next;
+  struct object *prev;
+} object_t;
+
+//============================ OLD LINKED LIST ==============================//
+static object_t *list_head = NULL;
+static int list_max_id = MIN_ID - 1;
+
+static object_t *list_find(int id) {
+  object_t *next = list_head;
+  while (next != NULL) {
+    if (next->id == id) {
+      return next;
+    }
+    next = next->next;
+  }
+  return NULL;
+}
+
+static int list_insert(object_t *object) {
+  object->id = ++list_max_id;
+  object->prev = NULL;
+  object->next = list_head;
+  if (list_head != NULL) {
+    list_head->prev = object;
+  }
+  list_head = object;
+  return object->id;
+}
+
+static void list_remove(object_t *object) {
+  if (object == list_head) {
+    list_head = object->next;
+  }
+  if (object->prev != NULL) {
+    object->prev->next = object->next;
+  }
+  if (object->next != NULL) {
+    object->next->prev = object->prev;
+  }
+}
+
+//============================ BENCHMARK HELPERS ==============================//
+static double now_ns() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/*
+* Shuffles ids into a random order
+*/
+static void shuffle(int *ids, int num_ids) {
+  for (int i=num_ids-1; i>0; i--) {
+    int j = rand() % (i + 1);
+    int tmp = ids[i];
+    ids[i] = ids[j];
+    ids[j] = tmp;
+  }
+}
+
+static void check_found(object_t *object, int id, char *who) {
+  if (object == NULL || object->id != id) {
+    fprintf(stderr, "%s: lookup of id %d failed\n", who, id);
+    exit(1);
+  }
+}
+
+/*
+* Times create, find and reclaim of num_objects objects on the linked list; ns per operation
+*/
+static void bench_list(int num_objects, int find_ops, double *create_ns, double *find_ns, double *reclaim_ns) {
+  object_t *objects = malloc(sizeof(object_t) * num_objects);
+  int *ids = malloc(sizeof(int) * num_objects);
+  list_head = NULL;
+  list_max_id = MIN_ID - 1;
+
+  double start = now_ns();
+  for (int i=0; i<num_objects; i++) {
+    ids[i] = list_insert(&objects[i]);
+  }
+  *create_ns = (now_ns() - start) / num_objects;
+
+  srand(58);
+  start = now_ns();
+  for (int i=0; i<find_ops; i++) {
+    int id = ids[rand() % num_objects];
+    check_found(list_find(id), id, "list");
+  }
+  *find_ns = (now_ns() - start) / find_ops;
+
+  shuffle(ids, num_objects);
+  start = now_ns();
+  for (int i=0; i<num_objects; i++) {
+    object_t *object = list_find(ids[i]);
+    check_found(object, ids[i], "list");
+    list_remove(object);
+  }
+  *reclaim_ns = (now_ns() - start) / num_objects;
+
+  free(objects);
+  free(ids);
+}
+
+/*
+* Times create, find and reclaim of num_objects objects in an id table; ns per operation
+*/
+static void bench_id_table(int num_objects, int find_ops, double *create_ns, double *find_ns, double *reclaim_ns) {
+  object_t *objects = malloc(sizeof(object_t) * num_objects);
+  int *ids = malloc(sizeof(int) * num_objects);
+  id_table_t *table = create_id_table(MIN_ID, MAX_ID);
+
+  double start = now_ns();
+  for (int i=0; i<num_objects; i++) {
+    objects[i].id = id_table_insert(table, &objects[i]);
+    ids[i] = objects[i].id;
+  }
+  *create_ns = (now_ns() - start) / num_objects;
+
+  srand(58);
+  start = now_ns();
+  for (int i=0; i<find_ops; i++) {
+    int id = ids[rand() % num_objects];
+    check_found(id_table_find(table, id), id, "id table");
+  }
+  *find_ns = (now_ns() - start) / find_ops;
+
+  shuffle(ids, num_objects);
+  start = now_ns();
+  for (int i=0; i<num_objects; i++) {
+    check_found(id_table_remove(table, ids[i]), ids[i], "id table");
+  }
+  *reclaim_ns = (now_ns() - start) / num_objects;
+
+  if (table->num_entries != 0 || id_table_find(table, ids[0]) != NULL) {
+    fprintf(stderr, "id table: %d entries left after reclaiming everything\n", table->num_entries);
+    exit(1);
+  }
+  for (int i=0; i<table->num_leaves; i++) {
+    free(table->leaves[i]);
+  }
+  free(table->leaves);
+  free(table->leaf_counts);
+  free(table);
+  free(objects);
+  free(ids);
+}
+
+/*
+* Checks that ids wrap around to reclaimed ones once the range is used up, and that a full table refuses inserts
+*/
+static void check_id_reuse() {
+  object_t objects[4];
+  id_table_t *table = create_id_table(10, 12);
+  for (int i=0; i<3; i++) {
+    objects[i].id = id_table_insert(table, &objects[i]);
+  }
+  if (id_table_insert(table, &objects[3]) != ERROR) {
+    fprintf(stderr, "id table: insert into a full table succeeded\n");
+    exit(1);
+  }
+  id_table_remove(table, 11);
+  if (id_table_insert(table, &objects[3]) != 11 || id_table_find(table, 11) != &objects[3]) {
+    fprintf(stderr, "id table: reclaimed id 11 wasn't handed out again\n");
+    exit(1);
+  }
+  if (id_table_find(table, 9) != NULL || id_table_find(table, 13) != NULL) {
+    fprintf(stderr, "id table: found an object outside the id range\n");
+    exit(1);
+  }
+}
+
+int main() {
+  int counts[] = {16, 256, 4096, 65536};
+  int num_counts = sizeof(counts) / sizeof(counts[0]);
+
+  check_id_reuse();
+  printf("lock/cvar/pipe lookup by id (ns per operation)\n");
+  printf("%8s | %13s %13s | %13s %13s | %13s %13s\n", "objects", "list create", "table create",
+         "list find", "table find", "list reclaim", "table reclaim");
+  for (int i=0; i<num_counts; i++) {
+    // the list walks are quadratic in the object count, so the big runs do fewer lookups
+    int find_ops = (counts[i] > 4096) ? FIND_OPS / 100 : FIND_OPS;
+    double list_create, list_find_ns, list_reclaim, table_create, table_find, table_reclaim;
+    bench_list(counts[i], find_ops, &list_create, &list_find_ns, &list_reclaim);
+    bench_id_table(counts[i], find_ops, &table_create, &table_find, &table_reclaim);
+    printf("%8d | %13.1f %13.1f | %13.1f %13.1f | %13.1f %13.1f\n", counts[i], list_create, table_create,
+           list_find_ns, table_find, list_reclaim, table_reclaim);
+  }
+  return 0;
+}
@@ -0,0 +1,113 @@
+/*
+* Host-side microbenchmark for Delay's timers.
+*
+* Compares the timing wheel in data_structures/timer_wheel.c against the per-tick walk of every delayed
+* process it replaced (reproduced below). Each run keeps a fixed number of sleepers: whenever one wakes up it
+* Delays again for a random number of ticks, like a process looping on Delay.
+*
+*   tick   -- time for one clock trap's worth of timer work, including re-arming the sleepers that woke
+*
+* Build and run with `make run` in this directory.
+*/
+#include <ykernel.h>
+#include <time.h>
+#include "data_structures/timer_wheel.h"
+
+#define TICKS 20000
+#define MAX_DELAY 200                          // sleepers Delay for 1..MAX_DELAY ticks
+
+typedef struct sleeper {
+  int delayed_clock_cycles;                    // for the old walk
+  tick_timer_t timer;                          // for the wheel
+} sleeper_t;
+
+static timer_wheel_t *wheel;
+static long num_wakeups;
+
+//============================ OLD DELAY WALK ==============================//
+/*
+* One tick of the old handle_trap_clock: decrement every sleeper, waking those that reach 0
+*/
+static void walk_tick(sleeper_t *sleepers, int num_sleepers) {
+  for (int i=0; i<num_sleepers; i++) {
+    sleepers[i].delayed_clock_cycles--;
+    if (sleepers[i].delayed_clock_cycles <= 0) {
+      num_wakeups++;
+      sleepers[i].delayed_clock_cycles = 1 + rand() % MAX_DELAY;
+    }
+  }
+}
+
+//============================ BENCHMARK HELPERS ==============================//
+static double now_ns() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void wake_and_delay_again(tick_timer_t *timer) {
+  num_wakeups++;
+  add_timer(wheel, timer, 1 + rand() % MAX_DELAY);
+}
+
+/*
+* Times TICKS ticks of the old walk with num_sleepers sleepers; ns per tick, and counts wakeups
+*/
+static double bench_walk(int num_sleepers, long *wakeups) {
+  sleeper_t *sleepers = malloc(sizeof(sleeper_t) * num_sleepers);
+  srand(58);
+  for (int i=0; i<num_sleepers; i++) {
+    sleepers[i].delayed_clock_cycles = 1 + rand() % MAX_DELAY;
+  }
+  num_wakeups = 0;
+  double start = now_ns();
+  for (int tick=0; tick<TICKS; tick++) {
+    walk_tick(sleepers, num_sleepers);
+  }
+  double tick_ns = (now_ns() - start) / TICKS;
+  *wakeups = num_wakeups;
+  free(sleepers);
+  return tick_ns;
+}
+
+/*
+* Times TICKS ticks of the wheel with num_sleepers sleepers; ns per tick, and counts wakeups
+*/
+static double bench_wheel(int num_sleepers, long *wakeups) {
+  sleeper_t *sleepers = malloc(sizeof(sleeper_t) * num_sleepers);
+  wheel = create_timer_wheel();
+  srand(58);
+  for (int i=0; i<num_sleepers; i++) {
+    init_timer(&sleepers[i].timer, &wake_and_delay_again, &sleepers[i]);
+    add_timer(wheel, &sleepers[i].timer, 1 + rand() % MAX_DELAY);
+  }
+  num_wakeups = 0;
+  double start = now_ns();
+  for (int tick=0; tick<TICKS; tick++) {
+    advance_timer_wheel(wheel);
+  }
+  double tick_ns = (now_ns() - start) / TICKS;
+  if (wheel->num_armed != num_sleepers) {
+    fprintf(stderr, "timer wheel: %d timers armed, expected %d\n", wheel->num_armed, num_sleepers);
+    exit(1);
+  }
+  *wakeups = num_wakeups;
+  free(wheel);
+  free(sleepers);
+  return tick_ns;
+}
+
+int main() {
+  int counts[] = {4, 64, 1024, 16384};
+  int num_counts = sizeof(counts) / sizeof(counts[0]);
+
+  printf("Delay timers, sleepers re-Delaying for 1..%d ticks (ns per clock tick)\n", MAX_DELAY);
+  printf("%8s | %12s %12s | %14s %14s\n", "sleepers", "walk tick", "wheel tick", "walk wakeups", "wheel wakeups");
+  for (int i=0; i<num_counts; i++) {
+    long walk_wakeups, wheel_wakeups;
+    double walk_ns = bench_walk(counts[i], &walk_wakeups);
+    double wheel_ns = bench_wheel(counts[i], &wheel_wakeups);
+    printf("%8d | %12.1f %12.1f | %14ld %14ld\n", counts[i], walk_ns, wheel_ns, walk_wakeups, wheel_wakeups);
+  }
+  return 0;
+}
@@ -0,0 +1,20 @@
+/*
+* Host-side stand-in for the framework's ykernel.h, so that self-contained kernel data structures
+* can be compiled and timed with the host compiler. Only what those files use is provided here;
+* kernel code that touches hardware registers or the page tables can't be built against this.
+*/
+#ifndef CURRENT_CHUNGUS_BENCH_YKERNEL_H
+#define CURRENT_CHUNGUS_BENCH_YKERNEL_H
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#define ERROR (-1)
+#define SUCCESS 0
+
+#define TracePrintf(level, ...) ((void) 0)
+
+#endif //CURRENT_CHUNGUS_BENCH_YKERNEL_H
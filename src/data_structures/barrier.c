@@ -0,0 +1,64 @@
+#include <ykernel.h>
+#include "barrier.h"
+#include "queue.h"
+#include "slab.h"
+#include "../kernel_start.h"
+
+static slab_cache_t *barrier_cache = NULL;
+
+/*
+ * Creates a barrier for num_parties processes with the next free id, and puts it in the barrier table
+ */
+barrier_t* create_barrier_any_id(int num_parties)
+{
+  if (barrier_cache == NULL) {
+    barrier_cache = create_slab_cache("barrier", sizeof(barrier_t), NULL);
+    if (barrier_cache == NULL) {
+      return NULL;
+    }
+  }
+  barrier_t* new_barrier = slab_alloc(barrier_cache);
+  if (new_barrier == NULL) {
+    TracePrintf(1, "CREATE_BARRIER: Failed to allocate memory for a new barrier\n");
+    return NULL;
+  }
+  new_barrier->num_parties = num_parties;
+  new_barrier->num_waiting = 0;
+  new_barrier->blocked_queue = create_queue();
+  if (new_barrier->blocked_queue == NULL) {
+    slab_free(barrier_cache, new_barrier);
+    return NULL;
+  }
+
+  int barrier_id = id_table_insert(barrier_table, new_barrier);
+  if (barrier_id == ERROR) {
+    TracePrintf(1, "CREATE_BARRIER: Ran out of space to allocate new barrier ids\n");
+    delete_queue(new_barrier->blocked_queue);
+    slab_free(barrier_cache, new_barrier);
+    return NULL;
+  }
+  new_barrier->id = barrier_id;
+
+  return new_barrier;
+}
+
+/*
+ * Finds the barrier in the barrier table
+ */
+barrier_t* find_barrier(int barrier_id)
+{
+  return id_table_find(barrier_table, barrier_id);
+}
+
+/*
+ * Takes the barrier out of the barrier table and deletes it
+ */
+int delete_barrier(barrier_t* barrier)
+{
+  if (barrier != NULL) {
+    id_table_remove(barrier_table, barrier->id);
+    delete_queue(barrier->blocked_queue);
+  }
+  slab_free(barrier_cache, barrier);
+  return SUCCESS;
+}
@@ -0,0 +1,29 @@
+#ifndef CURRENT_CHUNGUS_BARRIER_H
+#define CURRENT_CHUNGUS_BARRIER_H
+
+#include <ykernel.h>
+#include "queue.h"
+
+typedef struct barrier {
+  int id;
+  int num_parties;                                   // processes that have to arrive before any of them leaves
+  int num_waiting;                                   // processes blocked in BarrierWait this round
+  queue_t* blocked_queue;
+} barrier_t;
+
+/*
+ * Creates a barrier for num_parties processes with the next free id, and puts it in the barrier table
+ */
+barrier_t* create_barrier_any_id(int num_parties);
+
+/*
+ * Finds the barrier in the barrier table
+ */
+barrier_t* find_barrier(int barrier_id);
+
+/*
+ * Takes the barrier out of the barrier table and deletes it; we assume blocked_queue to already be empty
+ */
+int delete_barrier(barrier_t* barrier);
+
+#endif //CURRENT_CHUNGUS_BARRIER_H
@@ -1,25 +1,34 @@
 #include "cvar.h"
 #include "queue.h"
+#include "slab.h"
 #include "../kernel_start.h"
 #include <ykernel.h>
 
+static slab_cache_t *cvar_cache = NULL;
+
 /*
  * Create a cvar with a particular id
- * The caller is trusted to not allocate a cvar with an id already on the cvar list
+ * The cvar isn't put in the cvar table
  */
 cvar_t* create_cvar(int cvar_id)
 {
-  cvar_t* new_cvar = malloc(sizeof (cvar_t));
+  if (cvar_cache == NULL) {
+    cvar_cache = create_slab_cache("cvar", sizeof(cvar_t), NULL);
+    if (cvar_cache == NULL) {
+      return NULL;
+    }
+  }
+  cvar_t* new_cvar = slab_alloc(cvar_cache);
   if (new_cvar == NULL) {
     TracePrintf(1, "CREATE_CVAR: Unable to malloc a new cvar\n");
+    return NULL;
   }
   new_cvar->id = cvar_id;
   new_cvar->blocked_queue = create_queue();
-  new_cvar->next_cvar = NULL;
-  new_cvar->prev_cvar = NULL;
 
   if (new_cvar->blocked_queue == NULL) {
     TracePrintf(1, "CREATE_CVAR: Failed to allocate blocked queue\n");
+    slab_free(cvar_cache, new_cvar);
     return NULL;
   }
 
@@ -27,30 +36,25 @@ cvar_t* create_cvar(int cvar_id)
 }
 
 /*
- * Find the next available id to allocate the cvar with
+ * Create a cvar with the next free id and put it in the cvar table
  */
 cvar_t* create_cvar_any_id() {
-  int cvar_id = ++max_cvar_id;
-  if (cvar_id > max_possible_cvar_id) {
-    TracePrintf(1, "CREATE_CVAR_ANY_ID: Ran out of space to allocate new cvar ids\n");
-    return NULL;
-  }
-
-  cvar_t* new_cvar = create_cvar(cvar_id);
+  cvar_t* new_cvar = create_cvar(ERROR);
   if (new_cvar == NULL) {
     TracePrintf(1, "CREATE_CVAR_ANY_ID: Failed to allocate new cvar\n");
     return NULL;
   }
 
-  // stick the cvar in the list
-  cvar_t* old_cvars = cvars;
-  cvars = new_cvar;
-  new_cvar->next_cvar = old_cvars;
-  if (old_cvars != NULL) {
-    old_cvars->prev_cvar = new_cvar;
+  int cvar_id = id_table_insert(cvar_table, new_cvar);
+  if (cvar_id == ERROR) {
+    TracePrintf(1, "CREATE_CVAR_ANY_ID: Ran out of space to allocate new cvar ids\n");
+    delete_queue(new_cvar->blocked_queue);
+    slab_free(cvar_cache, new_cvar);
+    return NULL;
   }
+  new_cvar->id = cvar_id;
 
-  return cvars;
+  return new_cvar;
 }
 
 /*
@@ -58,26 +62,18 @@ cvar_t* create_cvar_any_id() {
  */
 cvar_t* find_cvar(int cvar_id)
 {
-  cvar_t* next_cvar = cvars;
-  while (next_cvar != NULL) {
-//    TracePrintf(1, "cvar: %d\n", next_cvar->id);
-    if (next_cvar->id == cvar_id) {
-      return next_cvar;
-    }
-    next_cvar = next_cvar->next_cvar;
-  }
-
-  return NULL;
+  return id_table_find(cvar_table, cvar_id);
 }
 
 /*
- * Delete a cvar; we assume blocked_queue to already be empty
+ * Take a cvar out of the cvar table and delete it; we assume blocked_queue to already be empty
  */
 int delete_cvar(cvar_t* cvar)
 {
   if (cvar != NULL) {
-    free(cvar->blocked_queue);
+    id_table_remove(cvar_table, cvar->id);
+    delete_queue(cvar->blocked_queue);
   }
-  free(cvar);
+  slab_free(cvar_cache, cvar);
   return SUCCESS;
 }
\ No newline at end of file
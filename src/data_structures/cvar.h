@@ -7,18 +7,16 @@
 typedef struct cvar_struct{
   int id;
   queue_t* blocked_queue;
-  struct cvar_struct* next_cvar;
-  struct cvar_struct* prev_cvar;
 } cvar_t;
 
 /*
  * Create a cvar with a particular id
- * The caller is trusted to not allocate a cvar with an id already on the cvar list
+ * The cvar isn't put in the cvar table
  */
 cvar_t* create_cvar(int cvar_id);
 
 /*
- * Find the next available id to allocate the cvar with
+ * Create a cvar with the next free id and put it in the cvar table
  */
 cvar_t* create_cvar_any_id();
 
@@ -28,7 +26,7 @@ cvar_t* create_cvar_any_id();
 cvar_t* find_cvar(int cvar_id);
 
 /*
- * Delete a cvar
+ * Take a cvar out of the cvar table and delete it
  */
 int delete_cvar(cvar_t* cvar);
 
@@ -3,40 +3,366 @@
 
 //============================ FRAME TABLE HELPERS ==============================//
 /*
-return the number of free frames, to help during dynamic allocation. 
-This assumes that the kernel is uninterruptable and needs no synchronization (mutexes, etc.)
+* returns true if frame_num names a frame in this table
 */
-int get_num_free_frames(char *frame_table, int frame_table_size) {
-  int numfree = 0;
-  for (int i=0; i<frame_table_size; i++) {
-    // sum the number of unused frame table frames (1 is used, 0 unused)
-    numfree += (frame_table[i] ? 0 : 1);
+static bool frame_in_range(frame_table_struct_t *frame_table, int frame_num) {
+  return frame_num >= 0 && frame_num < frame_table->frame_table_size;
+}
+
+/*
+* Push a free block of 2^order frames starting at head onto the front of that order's free list
+*/
+static void push_free_block(frame_table_struct_t *frame_table, int head, int order) {
+  frame_desc_t *frame = &frame_table->frames[head];
+  frame->free_head = true;
+  frame->order = order;
+  frame->prev_free = FRAME_NONE;
+  frame->next_free = frame_table->free_list_heads[order];
+  if (frame_table->free_list_heads[order] != FRAME_NONE) {
+    frame_table->frames[frame_table->free_list_heads[order]].prev_free = head;
+  }
+  frame_table->free_list_heads[order] = head;
+  frame_table->free_blocks[order]++;
+  frame_table->num_free_frames += (1 << order);
+}
+
+/*
+* Unlink a free block from wherever it sits in its order's free list
+*/
+static void unlink_free_block(frame_table_struct_t *frame_table, int head) {
+  frame_desc_t *frame = &frame_table->frames[head];
+  int order = frame->order;
+  if (frame->prev_free != FRAME_NONE) {
+    frame_table->frames[frame->prev_free].next_free = frame->next_free;
+  }
+  else {
+    frame_table->free_list_heads[order] = frame->next_free;
+  }
+  if (frame->next_free != FRAME_NONE) {
+    frame_table->frames[frame->next_free].prev_free = frame->prev_free;
+  }
+  frame->free_head = false;
+  frame->next_free = FRAME_NONE;
+  frame->prev_free = FRAME_NONE;
+  frame_table->free_blocks[order]--;
+  frame_table->num_free_frames -= (1 << order);
+}
+
+/*
+* Returns the first frame of the free block containing frame_num, or FRAME_NONE if frame_num is in use
+*/
+static int find_free_block(frame_table_struct_t *frame_table, int frame_num) {
+  for (int order=0; order<=FRAME_MAX_ORDER; order++) {
+    int head = frame_num & ~((1 << order) - 1);
+    if (frame_table->frames[head].free_head && frame_table->frames[head].order == order) {
+      return head;
+    }
+  }
+  return FRAME_NONE;
+}
+
+/*
+* Takes a free block of at least 2^order frames off the free lists and splits it down to exactly 2^order,
+* returning the pieces it doesn't need to the free lists.
+* return the first frame of the block, or FRAME_NONE if no block is large enough
+*/
+static int take_free_block(frame_table_struct_t *frame_table, int order) {
+  int block_order = order;
+  while (block_order <= FRAME_MAX_ORDER && frame_table->free_list_heads[block_order] == FRAME_NONE) {
+    block_order++;
+  }
+  if (block_order > FRAME_MAX_ORDER) {
+    return FRAME_NONE;
+  }
+
+  int head = frame_table->free_list_heads[block_order];
+  unlink_free_block(frame_table, head);
+  int splits = 0;
+  // keep the lower half and free the upper half until the block is the size we want
+  while (block_order > order) {
+    block_order--;
+    push_free_block(frame_table, head + (1 << block_order), block_order);
+    splits++;
+  }
+  frame_table->num_splits += splits;
+  if (splits > frame_table->max_alloc_splits) {
+    frame_table->max_alloc_splits = splits;
+  }
+  return head;
+}
+
+/*
+* Return a single frame to the free lists, merging it with its buddy for as long as the buddy is a free
+* block of the same order
+*/
+static void free_and_merge(frame_table_struct_t *frame_table, int frame_num) {
+  int head = frame_num;
+  int order = 0;
+  while (order < FRAME_MAX_ORDER) {
+    int buddy = head ^ (1 << order);
+    if (buddy >= frame_table->frame_table_size ||
+        !frame_table->frames[buddy].free_head ||
+        frame_table->frames[buddy].order != order
+        ) {
+      break;
+    }
+    unlink_free_block(frame_table, buddy);
+    head = (head < buddy) ? head : buddy;
+    order++;
+    frame_table->num_merges++;
   }
-  return numfree;
+  push_free_block(frame_table, head, order);
 }
 
 /*
-Traverses frame table bit vector to find the index
-of the next free frame. This assumes that the kernel is uninterruptable
-and needs no synchronization (mutexes, etc.)
+* Create a frame table tracking num_frames frames, all of them free. Returns NULL if we can't allocate it.
 */
-int get_free_frame(char *frame_table, int frame_table_size, int iterator_start) {
+frame_table_struct_t *create_frame_table(int num_frames) {
+  frame_table_struct_t *frame_table = malloc(sizeof(frame_table_struct_t));
+  if (frame_table == NULL) {
+    TracePrintf(1, "CREATE_FRAME_TABLE: Failed to allocate memory for the frame table\n");
+    return NULL;
+  }
+  frame_table->frames = malloc(sizeof(frame_desc_t) * num_frames);
+  if (frame_table->frames == NULL) {
+    TracePrintf(1, "CREATE_FRAME_TABLE: Failed to allocate memory for the frame descriptors\n");
+    free(frame_table);
+    return NULL;
+  }
+  frame_table->frame_table_size = num_frames;
+  frame_table->num_free_frames = 0;
+  frame_table->num_allocs = 0;
+  frame_table->num_alloc_failures = 0;
+  frame_table->num_splits = 0;
+  frame_table->num_merges = 0;
+  frame_table->max_alloc_splits = 0;
+  for (int order=0; order<=FRAME_MAX_ORDER; order++) {
+    frame_table->free_list_heads[order] = FRAME_NONE;
+    frame_table->free_blocks[order] = 0;
+  }
+
+  for (int i=0; i<num_frames; i++) {
+    frame_table->frames[i].refcount = 0;
+    frame_table->frames[i].owner_pid = FRAME_OWNER_NONE;
+    frame_table->frames[i].pinned = false;
+    frame_table->frames[i].free_head = false;
+    frame_table->frames[i].order = 0;
+    frame_table->frames[i].next_free = FRAME_NONE;
+    frame_table->frames[i].prev_free = FRAME_NONE;
+  }
+
+  // carve memory into the largest aligned blocks that fit...
+  int i = 0;
+  while (i < num_frames) {
+    int order = FRAME_MAX_ORDER;
+    while (order > 0 && ((i & ((1 << order) - 1)) || i + (1 << order) > num_frames)) {
+      order--;
+    }
+    frame_table->frames[i].order = order;
+    frame_table->frames[i].free_head = true;
+    i += (1 << order);
+  }
+  // ...and push them in reverse so that low frames are handed out first
+  for (i=num_frames-1; i>=0; i--) {
+    if (frame_table->frames[i].free_head) {
+      push_free_block(frame_table, i, frame_table->frames[i].order);
+    }
+  }
+  return frame_table;
+}
+
+/*
+* Mark a frame as permanently used by the kernel (at boot, for kernel text, data and stack)
+*/
+void reserve_frame(frame_table_struct_t *frame_table, int frame_num) {
+  if (!frame_in_range(frame_table, frame_num)) {
+    return;
+  }
+  if (frame_table->frames[frame_num].refcount == 0) {
+    // split the free block around this frame, returning every other piece to the free lists
+    int head = find_free_block(frame_table, frame_num);
+    int order = frame_table->frames[head].order;
+    unlink_free_block(frame_table, head);
+    while (order > 0) {
+      order--;
+      int upper = head + (1 << order);
+      if (frame_num >= upper) {
+        push_free_block(frame_table, head, order);
+        head = upper;
+      }
+      else {
+        push_free_block(frame_table, upper, order);
+      }
+    }
+  }
+  frame_table->frames[frame_num].refcount = 1;
+  frame_table->frames[frame_num].owner_pid = FRAME_OWNER_KERNEL;
+  frame_table->frames[frame_num].pinned = true;
+}
+
+/*
+return the number of free frames, to help during dynamic allocation.
+*/
+int get_num_free_frames(frame_table_struct_t *frame_table) {
+  return frame_table->num_free_frames;
+}
+
+/*
+* Hands each frame in a block just taken off the free lists to owner_pid with a single reference
+*/
+static void hand_out_block(frame_table_struct_t *frame_table, int head, int order, int owner_pid) {
+  frame_table->num_allocs++;
+  for (int i=head; i<head+(1 << order); i++) {
+    frame_table->frames[i].refcount = 1;
+    frame_table->frames[i].owner_pid = owner_pid;
+    frame_table->frames[i].pinned = false;
+  }
+}
+
+/*
+* Takes a block of 2^order frames and hands it to owner_pid.
+*/
+int alloc_frames(frame_table_struct_t *frame_table, int order, int owner_pid) {
+  if (order < 0 || order > FRAME_MAX_ORDER) {
+    TracePrintf(1, "ALLOC_FRAMES: Can't allocate a block of order %d\n", order);
+    frame_table->num_alloc_failures++;
+    return MEMFULL;
+  }
+  int head = take_free_block(frame_table, order);
+  if (head == FRAME_NONE) {
+    frame_table->num_alloc_failures++;
+    return MEMFULL;
+  }
+  hand_out_block(frame_table, head, order, owner_pid);
+  return head;
+}
+
+/*
+Allocates a single frame and hands it to owner_pid with a single reference.
+*/
+int get_free_frame(frame_table_struct_t *frame_table, int owner_pid) {
   TracePrintf(5, "Looking for more free frames\n");
-  int i;
-  for (i = iterator_start; i < frame_table_size; i++) {
-    if (frame_table[i] == 0) {
-      frame_table[i] = 1;
-      return i;
+  return alloc_frames(frame_table, 0, owner_pid);
+}
+
+/*
+* Allocates num_frames frames in the largest runs we can find. Checking the free count up front means
+* the loop can't fail: an order-0 block always exists while any frame is free.
+*/
+int get_free_frames(frame_table_struct_t *frame_table, int num_frames, int owner_pid, int *pfns) {
+  if (num_frames > frame_table->num_free_frames) {
+    TracePrintf(1, "GET_FREE_FRAMES: Only %d free frames for a request of %d\n",
+                frame_table->num_free_frames, num_frames);
+    frame_table->num_alloc_failures++;
+    return MEMFULL;
+  }
+  int filled = 0;
+  while (filled < num_frames) {
+    // the largest run that fits in what's left of the request...
+    int order = 0;
+    while (order < FRAME_MAX_ORDER && (1 << (order+1)) <= num_frames - filled) {
+      order++;
+    }
+    // ...that the free lists can actually supply
+    int head = take_free_block(frame_table, order);
+    while (head == FRAME_NONE) {
+      order--;
+      head = take_free_block(frame_table, order);
+    }
+    hand_out_block(frame_table, head, order, owner_pid);
+    for (int i=0; i<(1 << order); i++) {
+      pfns[filled++] = head + i;
     }
   }
-  return MEMFULL;
+  return SUCCESS;
+}
+
+/*
+* Record one more mapping of an in-use frame. Pinned (kernel) frames are never shared.
+*/
+void share_frame(frame_table_struct_t *frame_table, int frame_num) {
+  if (!frame_in_range(frame_table, frame_num) || frame_table->frames[frame_num].refcount == 0) {
+    TracePrintf(1, "SHARE_FRAME: Frame %d is not in use and can't be shared\n", frame_num);
+    return;
+  }
+  if (frame_table->frames[frame_num].pinned) {
+    TracePrintf(1, "SHARE_FRAME: Frame %d is pinned kernel memory and can't be shared\n", frame_num);
+    return;
+  }
+  frame_table->frames[frame_num].refcount++;
 }
 
 /*
-* Free a frame in the frame table
+* Drop one mapping of a frame. If other pages still map it we only decrement the refcount;
+* otherwise the frame is returned to the free pool.
 */
-void free_frame(char *frame_table, int frame_table_size, int frame_num) {
-  if (frame_num < frame_table_size) {
-    frame_table[frame_num] = 0;
+void release_frame(frame_table_struct_t *frame_table, int frame_num) {
+  if (!frame_in_range(frame_table, frame_num) || frame_table->frames[frame_num].refcount == 0) {
+    TracePrintf(1, "RELEASE_FRAME: Frame %d is already free\n", frame_num);
+    return;
   }
-}
\ No newline at end of file
+  frame_table->frames[frame_num].refcount--;
+  if (frame_table->frames[frame_num].refcount == 0) {
+    frame_table->frames[frame_num].owner_pid = FRAME_OWNER_NONE;
+    frame_table->frames[frame_num].pinned = false;
+    free_and_merge(frame_table, frame_num);
+  }
+}
+
+/*
+* return true if more than one page maps this frame
+*/
+bool frame_is_shared(frame_table_struct_t *frame_table, int frame_num) {
+  if (!frame_in_range(frame_table, frame_num)) {
+    return false;
+  }
+  return frame_table->frames[frame_num].refcount > 1;
+}
+
+/*
+* Pin a frame, marking it as kernel memory
+*/
+void pin_frame(frame_table_struct_t *frame_table, int frame_num) {
+  if (frame_in_range(frame_table, frame_num)) {
+    frame_table->frames[frame_num].pinned = true;
+  }
+}
+
+/*
+* Unpin a frame
+*/
+void unpin_frame(frame_table_struct_t *frame_table, int frame_num) {
+  if (frame_in_range(frame_table, frame_num)) {
+    frame_table->frames[frame_num].pinned = false;
+  }
+}
+
+/*
+* Fill in stats with the allocator's current free-block counts, fragmentation and counters
+*/
+void get_frame_stats(frame_table_struct_t *frame_table, frame_stats_t *stats) {
+  stats->num_free_frames = frame_table->num_free_frames;
+  stats->largest_free_order = -1;
+  for (int order=0; order<=FRAME_MAX_ORDER; order++) {
+    stats->free_blocks[order] = frame_table->free_blocks[order];
+    if (frame_table->free_blocks[order] > 0) {
+      stats->largest_free_order = order;
+    }
+  }
+  // frames sitting in blocks of at least each order, counting down from the largest
+  int usable_frames = 0;
+  for (int order=FRAME_MAX_ORDER; order>=0; order--) {
+    usable_frames += frame_table->free_blocks[order] << order;
+    if (frame_table->num_free_frames == 0) {
+      stats->fragmentation[order] = 0;
+    }
+    else {
+      stats->fragmentation[order] = 100 * (frame_table->num_free_frames - usable_frames) / frame_table->num_free_frames;
+    }
+  }
+  stats->num_allocs = frame_table->num_allocs;
+  stats->num_alloc_failures = frame_table->num_alloc_failures;
+  stats->num_splits = frame_table->num_splits;
+  stats->num_merges = frame_table->num_merges;
+  stats->max_alloc_splits = frame_table->max_alloc_splits;
+}
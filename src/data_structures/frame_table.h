@@ -3,27 +3,142 @@
 
 #include <ykernel.h>
 #define MEMFULL -1
+#define FRAME_OWNER_NONE -1                    // owner of a free frame
+#define FRAME_OWNER_KERNEL -2                  // owner of kernel text, data, heap and boot-time frames
+#define FRAME_NONE -1                          // end of a free list
+#define FRAME_MAX_ORDER 10                     // largest buddy block is 2^FRAME_MAX_ORDER frames
 
+/*
+* Everything we know about one physical frame. A frame is free exactly when its refcount is 0.
+*   refcount   -- the number of page table entries mapping this frame (more than one when shared copy-on-write)
+*   owner_pid  -- the pid the frame was allocated for (FRAME_OWNER_KERNEL for kernel memory); frames stay
+*                 charged to their allocator while shared
+*   pinned     -- kernel memory (text, data, heap, kernel stacks) that must never be shared or reclaimed
+*   free_head  -- this frame is the first frame of a free buddy block of 2^order frames
+*   order      -- the order of the free block this frame heads (only meaningful when free_head is set)
+*   next_free/prev_free -- links in that order's free list while free_head is set (FRAME_NONE otherwise)
+*/
+typedef struct frame_desc {
+  int refcount;
+  int owner_pid;
+  bool pinned;
+  bool free_head;
+  int order;
+  int next_free;
+  int prev_free;
+} frame_desc_t;
+
+/*
+* Free frames are managed by a binary buddy allocator. Free memory is kept as blocks of 2^k frames
+* (aligned to 2^k), one doubly linked free list per order threaded through the descriptors of the
+* blocks' first frames. Allocating splits the smallest big-enough block; freeing a frame merges it
+* with its buddy for as long as the buddy is also wholly free. Every allocated frame is still
+* reference counted and released on its own, so a run handed out together can be unmapped a page
+* at a time.
+*
+* The counters after num_free_frames are statistics for tuning; see get_frame_stats.
+*/
 typedef struct frame_table_struct{
-  char *frame_table;
+  frame_desc_t *frames;
   int frame_table_size;
+  int free_list_heads[FRAME_MAX_ORDER+1];
+  int free_blocks[FRAME_MAX_ORDER+1];
+  int num_free_frames;
+  int num_allocs;
+  int num_alloc_failures;
+  int num_splits;
+  int num_merges;
+  int max_alloc_splits;
 } frame_table_struct_t;
 
+/*
+* A snapshot of the allocator's state, for tuning
+*   free_blocks       -- the number of free blocks of each order
+*   fragmentation     -- for each order, the percentage of free frames that can't be used to satisfy a
+*                        request of that order because they sit in smaller blocks
+*   largest_free_order -- the largest order that can currently be allocated (-1 if memory is full)
+*   num_allocs/num_alloc_failures -- allocation requests that succeeded and failed
+*   num_splits/num_merges -- blocks split on allocation and buddies merged on free
+*   max_alloc_splits  -- the most splits a single allocation needed (its worst-case latency)
+*/
+typedef struct frame_stats {
+  int free_blocks[FRAME_MAX_ORDER+1];
+  int fragmentation[FRAME_MAX_ORDER+1];
+  int num_free_frames;
+  int largest_free_order;
+  int num_allocs;
+  int num_alloc_failures;
+  int num_splits;
+  int num_merges;
+  int max_alloc_splits;
+} frame_stats_t;
+
 //=================== FRAME TABLE FUNCTIONS =================//
+/*
+* All allocation, sharing and freeing of physical frames goes through these functions; nothing else should
+* touch the frame descriptors directly. This assumes that the kernel is uninterruptable and needs no
+* synchronization (mutexes, etc.)
+*/
+
+/*
+* Create a frame table tracking num_frames frames, all of them free. Returns NULL if we can't allocate it.
+*/
+frame_table_struct_t *create_frame_table(int num_frames);
+
+/*
+* Mark a frame as permanently used by the kernel (at boot, for kernel text, data and stack)
+*/
+void reserve_frame(frame_table_struct_t *frame_table, int frame_num);
+
+/*
+* Allocate a free frame for owner_pid with a refcount of 1, in O(FRAME_MAX_ORDER).
+* return the number of the frame, or MEMFULL if memory is insufficient
+*/
+int get_free_frame(frame_table_struct_t *frame_table, int owner_pid);
+
+/*
+* Allocate 2^order physically contiguous frames for owner_pid, each with a refcount of 1.
+* return the number of the first frame, or MEMFULL if there is no free block that large
+*/
+int alloc_frames(frame_table_struct_t *frame_table, int order, int owner_pid);
+
+/*
+* Allocate num_frames frames for owner_pid, writing their numbers into pfns. The frames are taken in the
+* largest contiguous runs available. Either every frame is allocated and we return SUCCESS, or none
+* are and we return MEMFULL.
+*/
+int get_free_frames(frame_table_struct_t *frame_table, int num_frames, int owner_pid, int *pfns);
+
+/*
+* return the number of free frames, in O(1)
+*/
+int get_num_free_frames(frame_table_struct_t *frame_table);
+
+/*
+* Record one more mapping of an in-use frame (e.g. a page shared copy-on-write by fork)
+*/
+void share_frame(frame_table_struct_t *frame_table, int frame_num);
+
+/*
+* Drop one mapping of a frame; the frame goes back to the free pool (merging with its buddy) once
+* nothing maps it
+*/
+void release_frame(frame_table_struct_t *frame_table, int frame_num);
 
 /*
-* return the number of the next free frame, or MEMFULL if memory is insufficient
+* return true if more than one page maps this frame
 */
-int get_free_frame(char *frame_table, int frame_table_size, int iteration_start);
+bool frame_is_shared(frame_table_struct_t *frame_table, int frame_num);
 
 /*
-* return the number of free frames
+* Pin or unpin a frame. Pinned frames belong to the kernel and are never shared
 */
-int get_num_free_frames(char *frame_table, int frame_table_size);
+void pin_frame(frame_table_struct_t *frame_table, int frame_num);
+void unpin_frame(frame_table_struct_t *frame_table, int frame_num);
 
 /*
-* Free a frame in the frame table
+* Fill in stats with the allocator's current free-block counts, fragmentation and counters
 */
-void free_frame(char *frame_table, int frame_table_size, int frame_num);
+void get_frame_stats(frame_table_struct_t *frame_table, frame_stats_t *stats);
 
-#endif //CURRENT_CHUNGUS_FRAME_TABLE_H
\ No newline at end of file
+#endif //CURRENT_CHUNGUS_FRAME_TABLE_H
@@ -0,0 +1,74 @@
+#include <ykernel.h>
+#include "futex.h"
+#include "queue.h"
+#include "slab.h"
+
+static slab_cache_t *futex_cache = NULL;
+static futex_t *futex_buckets[FUTEX_HASH_BUCKETS];
+
+/*
+ * Lock words are usually int aligned, so drop the low bits before hashing
+ */
+static futex_t **futex_bucket(unsigned int key) {
+  return &futex_buckets[(key >> 2) % FUTEX_HASH_BUCKETS];
+}
+
+/*
+ * Returns the futex for this key, or NULL if nobody is waiting on it
+ */
+futex_t *find_futex(unsigned int key) {
+  for (futex_t *futex = *futex_bucket(key); futex != NULL; futex = futex->next) {
+    if (futex->key == key) {
+      return futex;
+    }
+  }
+  return NULL;
+}
+
+/*
+ * Returns the futex for this key, creating it if nobody is waiting on it yet
+ */
+futex_t *find_or_create_futex(unsigned int key) {
+  futex_t *futex = find_futex(key);
+  if (futex != NULL) {
+    return futex;
+  }
+
+  if (futex_cache == NULL) {
+    futex_cache = create_slab_cache("futex", sizeof(futex_t), NULL);
+    if (futex_cache == NULL) {
+      return NULL;
+    }
+  }
+  futex = slab_alloc(futex_cache);
+  if (futex == NULL) {
+    TracePrintf(1, "CREATE_FUTEX: Failed to allocate memory for a new futex\n");
+    return NULL;
+  }
+  futex->waiters = create_queue();
+  if (futex->waiters == NULL) {
+    slab_free(futex_cache, futex);
+    return NULL;
+  }
+  futex->key = key;
+  futex_t **bucket = futex_bucket(key);
+  futex->next = *bucket;
+  *bucket = futex;
+  return futex;
+}
+
+/*
+ * Deletes the futex if nobody is waiting on it anymore
+ */
+void put_futex(futex_t *futex) {
+  if (futex == NULL || !is_empty(futex->waiters)) {
+    return;
+  }
+  futex_t **link = futex_bucket(futex->key);
+  while (*link != futex) {
+    link = &(*link)->next;
+  }
+  *link = futex->next;
+  delete_queue(futex->waiters);
+  slab_free(futex_cache, futex);
+}
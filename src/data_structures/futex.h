@@ -0,0 +1,35 @@
+#ifndef CURRENT_CHUNGUS_FUTEX_H
+#define CURRENT_CHUNGUS_FUTEX_H
+
+#include <ykernel.h>
+#include "queue.h"
+
+/*
+ * Wait queues for FutexWait/FutexWake. A futex is just an int in user memory; the kernel only keeps a queue for a
+ * word while someone is blocked on it. Words are named by where they live in physical memory, so two processes
+ * mapping the same frame (see SharePages) find the same futex wherever the frame sits in their address spaces.
+ */
+#define FUTEX_HASH_BUCKETS 64
+
+typedef struct futex {
+  unsigned int key;                                  // (pfn << PAGESHIFT) | offset of the word
+  queue_t *waiters;
+  struct futex *next;                                // next futex in the same hash bucket
+} futex_t;
+
+/*
+ * Returns the futex for this key, or NULL if nobody is waiting on it
+ */
+futex_t *find_futex(unsigned int key);
+
+/*
+ * Returns the futex for this key, creating it if nobody is waiting on it yet. Returns NULL if we are out of memory.
+ */
+futex_t *find_or_create_futex(unsigned int key);
+
+/*
+ * Deletes the futex if nobody is waiting on it anymore
+ */
+void put_futex(futex_t *futex);
+
+#endif //CURRENT_CHUNGUS_FUTEX_H
@@ -0,0 +1,112 @@
+#include <ykernel.h>
+#include "id_table.h"
+
+/*
+* Create a table for ids in [min_id, max_id]. Returns NULL if we can't allocate it.
+*/
+id_table_t *create_id_table(int min_id, int max_id) {
+  id_table_t *table = malloc(sizeof(id_table_t));
+  if (table == NULL) {
+    TracePrintf(1, "CREATE_ID_TABLE: Unable to allocate memory for an id table\n");
+    return NULL;
+  }
+  table->min_id = min_id;
+  table->max_id = max_id;
+  table->next_id = min_id;
+  table->num_entries = 0;
+  table->num_leaves = ((max_id - min_id) >> ID_TABLE_LEAF_SHIFT) + 1;
+  table->leaves = malloc(sizeof(void **) * table->num_leaves);
+  table->leaf_counts = malloc(sizeof(int) * table->num_leaves);
+  if (table->leaves == NULL || table->leaf_counts == NULL) {
+    TracePrintf(1, "CREATE_ID_TABLE: Unable to allocate memory for the top level of an id table\n");
+    free(table->leaves);
+    free(table->leaf_counts);
+    free(table);
+    return NULL;
+  }
+  bzero(table->leaves, sizeof(void **) * table->num_leaves);
+  bzero(table->leaf_counts, sizeof(int) * table->num_leaves);
+  return table;
+}
+
+/*
+* Returns true if id is in the table's range and has no object stored under it
+*/
+static bool id_is_free(id_table_t *table, int id) {
+  int offset = id - table->min_id;
+  void **leaf = table->leaves[offset >> ID_TABLE_LEAF_SHIFT];
+  return leaf == NULL || leaf[offset & ID_TABLE_LEAF_MASK] == NULL;
+}
+
+/*
+* Give object the next free id and store it under that id.
+* Returns the id, or ERROR if the id range is used up or we can't allocate a leaf.
+*/
+int id_table_insert(id_table_t *table, void *object) {
+  int range = table->max_id - table->min_id + 1;
+  if (object == NULL || table->num_entries >= range) {
+    TracePrintf(1, "ID_TABLE_INSERT: Ran out of ids between %d and %d\n", table->min_id, table->max_id);
+    return ERROR;
+  }
+
+  // until the range has been used up once this takes the first probe; after that we skip over live ids
+  int id = table->next_id;
+  while (!id_is_free(table, id)) {
+    id = (id == table->max_id) ? table->min_id : id + 1;
+  }
+
+  int offset = id - table->min_id;
+  int leaf_index = offset >> ID_TABLE_LEAF_SHIFT;
+  if (table->leaves[leaf_index] == NULL) {
+    table->leaves[leaf_index] = malloc(sizeof(void *) * ID_TABLE_LEAF_SIZE);
+    if (table->leaves[leaf_index] == NULL) {
+      TracePrintf(1, "ID_TABLE_INSERT: Unable to allocate memory for an id table leaf\n");
+      return ERROR;
+    }
+    bzero(table->leaves[leaf_index], sizeof(void *) * ID_TABLE_LEAF_SIZE);
+  }
+  table->leaves[leaf_index][offset & ID_TABLE_LEAF_MASK] = object;
+  table->leaf_counts[leaf_index]++;
+  table->num_entries++;
+  table->next_id = (id == table->max_id) ? table->min_id : id + 1;
+  return id;
+}
+
+/*
+* Returns the object with this id, or NULL if there is none (including ids outside the table's range)
+*/
+void *id_table_find(id_table_t *table, int id) {
+  if (id < table->min_id || id > table->max_id) {
+    return NULL;
+  }
+  int offset = id - table->min_id;
+  void **leaf = table->leaves[offset >> ID_TABLE_LEAF_SHIFT];
+  if (leaf == NULL) {
+    return NULL;
+  }
+  return leaf[offset & ID_TABLE_LEAF_MASK];
+}
+
+/*
+* Removes and returns the object with this id, or NULL if there is none. The id may be handed out again later.
+*/
+void *id_table_remove(id_table_t *table, int id) {
+  void *object = id_table_find(table, id);
+  if (object == NULL) {
+    return NULL;
+  }
+  int offset = id - table->min_id;
+  int leaf_index = offset >> ID_TABLE_LEAF_SHIFT;
+  table->leaves[leaf_index][offset & ID_TABLE_LEAF_MASK] = NULL;
+  table->leaf_counts[leaf_index]--;
+  table->num_entries--;
+
+  // give an emptied leaf back to the heap, so a burst of short-lived objects doesn't pin memory. The leaf
+  // that next_id is in stays, or a single object being created and reclaimed would malloc a leaf every time.
+  int next_leaf_index = (table->next_id - table->min_id) >> ID_TABLE_LEAF_SHIFT;
+  if (table->leaf_counts[leaf_index] == 0 && leaf_index != next_leaf_index) {
+    free(table->leaves[leaf_index]);
+    table->leaves[leaf_index] = NULL;
+  }
+  return object;
+}
@@ -0,0 +1,52 @@
+#ifndef CURRENT_CHUNGUS_ID_TABLE_H
+#define CURRENT_CHUNGUS_ID_TABLE_H
+
+#include <ykernel.h>
+
+#define ID_TABLE_LEAF_SHIFT 10                         // each leaf covers 2^10 consecutive ids
+#define ID_TABLE_LEAF_SIZE (1 << ID_TABLE_LEAF_SHIFT)
+#define ID_TABLE_LEAF_MASK (ID_TABLE_LEAF_SIZE - 1)
+
+/*
+* An id table maps the ids in [min_id, max_id] to kernel objects (pipes, locks, cvars), and hands out the ids.
+*
+* It is a two-level radix array: the top level has one slot per ID_TABLE_LEAF_SIZE ids, pointing at a leaf
+* array of objects. Leaves are only allocated once an id in them is handed out, and are freed again when their
+* last object is removed, so a table covering a million ids costs a few KB until it is used.
+* Insert, find and remove are all a couple of array indexes.
+*
+* Ids are handed out in increasing order. Once next_id runs off the end of the range it wraps around to
+* the ids of objects that have since been removed.
+*/
+typedef struct id_table {
+  int min_id;                                          // the smallest id the table may hand out
+  int max_id;                                          // the largest id the table may hand out
+  int next_id;                                         // where the search for a free id starts
+  int num_entries;                                     // objects currently in the table
+  int num_leaves;                                      // size of the top level
+  void ***leaves;                                      // leaf arrays of objects, or NULL if nothing is there
+  int *leaf_counts;                                    // objects in each leaf
+} id_table_t;
+
+/*
+* Create a table for ids in [min_id, max_id]. Returns NULL if we can't allocate it.
+*/
+id_table_t *create_id_table(int min_id, int max_id);
+
+/*
+* Give object the next free id and store it under that id.
+* Returns the id, or ERROR if the id range is used up or we can't allocate a leaf.
+*/
+int id_table_insert(id_table_t *table, void *object);
+
+/*
+* Returns the object with this id, or NULL if there is none (including ids outside the table's range)
+*/
+void *id_table_find(id_table_t *table, int id);
+
+/*
+* Removes and returns the object with this id, or NULL if there is none. The id may be handed out again later.
+*/
+void *id_table_remove(id_table_t *table, int id);
+
+#endif //CURRENT_CHUNGUS_ID_TABLE_H
@@ -1,22 +1,18 @@
 #include <ykernel.h>
 #include "queue.h"
 #include "lock.h"
+#include "slab.h"
 #include "../kernel_start.h"
+#include "../syscalls/custom_syscalls.h"
+
+static slab_cache_t *lock_cache = NULL;
 
 /*
- * Finds the lock in the linked list of locks
+ * Finds the lock in the lock table
  */
 lock_t* find_lock(int lock_id)
 {
-  lock_t* next_lock = locks;
-  while (next_lock != NULL) {
-    if (next_lock->lock_id == lock_id) {
-      return next_lock;
-    }
-    next_lock = next_lock->next_lock;
-  }
-
-  return NULL;
+  return id_table_find(lock_table, lock_id);
 }
 
 /*
@@ -24,49 +20,48 @@ lock_t* find_lock(int lock_id)
  */
 lock_t* create_lock(int lock_id)
 {
-  lock_t* new_lock = malloc(sizeof (lock_t));
+  if (lock_cache == NULL) {
+    lock_cache = create_slab_cache("lock", sizeof(lock_t), NULL);
+    if (lock_cache == NULL) {
+      return NULL;
+    }
+  }
+  lock_t* new_lock = slab_alloc(lock_cache);
   if (new_lock == NULL) {
     TracePrintf(1, "CREATE_LOCK: Failed to allocate memory for a new lock\n");
     return NULL;
   }
   new_lock->locking_proc = NULL;
-  new_lock->next_lock = NULL;
-  new_lock->prev_lock = NULL;
   new_lock->locked = false;
 
   new_lock->lock_id = lock_id;
   new_lock->blocked_queue = create_queue();
 
   if (new_lock->blocked_queue == NULL) {
+    slab_free(lock_cache, new_lock);
     return NULL;
   }
   return new_lock;
 }
 
 /*
- * Creates a lock with any id
- *
- * also puts it into the locks list
+ * Creates a lock with the next free id and puts it in the lock table
  */
 lock_t* create_lock_any_id()
 {
-  int lock_id = ++max_lock_id;
-  if (lock_id > max_possible_lock_id) {
-    TracePrintf(1, "Run out of ID space to allocate more locks\n");
-    return NULL;
-  }
-  lock_t* new_lock = create_lock(lock_id);
+  lock_t* new_lock = create_lock(ERROR);
   if (new_lock == NULL) {
     return NULL;
   }
 
-  // stick the lock into the locks list
-  lock_t* old_locks = locks;
-  locks = new_lock;
-  new_lock->next_lock = old_locks;
-  if (old_locks != NULL) {
-    old_locks->prev_lock = new_lock;
+  int lock_id = id_table_insert(lock_table, new_lock);
+  if (lock_id == ERROR) {
+    TracePrintf(1, "Run out of ID space to allocate more locks\n");
+    delete_queue(new_lock->blocked_queue);
+    slab_free(lock_cache, new_lock);
+    return NULL;
   }
+  new_lock->lock_id = lock_id;
 
   return new_lock;
 }
@@ -92,6 +87,7 @@ int acquire(int lock_id)
   else {
     TracePrintf(1, "ACQUIRE_LOCK: Waiting for lock with id %d\n", lock_id);
 
+    // release hands the lock straight to us before waking us up, so this normally blocks just once
     while (lock->locking_proc != NULL && lock->locking_proc != running_process) {
       TracePrintf(1, "ACQUIRE_LOCK: Waiting for lock with id %d\n", lock_id);
       // put the process in the blocked queue for the lock
@@ -105,6 +101,34 @@ int acquire(int lock_id)
   }
 }
 
+/*
+ * Attempts to acquire a lock with this id, giving up after ticks clock ticks. Release hands the lock straight to
+ * the process it takes off the blocked queue, so if we weren't taken off by the timer we own the lock.
+ */
+int acquire_timeout(int lock_id, int ticks)
+{
+  lock_t* lock = find_lock(lock_id);
+  if (lock == NULL || ticks < 0) {
+    TracePrintf(1, "ACQUIRE_LOCK: Can't wait %d ticks for lock with id %d\n", ticks, lock_id);
+    return ERROR;
+  }
+
+  if (lock->locking_proc == NULL || lock->locking_proc == running_process) {
+    lock->locking_proc = running_process;
+    return SUCCESS;
+  }
+  if (ticks == 0) {
+    return TIMED_OUT;
+  }
+
+  TracePrintf(1, "ACQUIRE_LOCK: Waiting up to %d ticks for lock with id %d\n", ticks, lock_id);
+  if (block_with_timeout(lock->blocked_queue, ticks)) {
+    return TIMED_OUT;
+  }
+  // the lock may have been deleted out from under us instead
+  return (find_lock(lock_id) == lock && lock->locking_proc == running_process) ? SUCCESS : ERROR;
+}
+
 /*
  * Attempts to release a lock with this id
  * ERROR if lock doesn't exist, this process does not possess lock
@@ -128,15 +152,15 @@ int release(int lock_id)
   }
 
   lock->locking_proc = NULL;
-  TracePrintf(1, "RELEASE_LOCK: Passed ifs %d\n", lock_id);
-  // if there's another process waiting for the lock, give it the lock
+  // if there's another process waiting for the lock, hand it the lock directly: it owns the lock before it
+  // even runs, so nobody can barge in ahead of it and it never wakes up only to block again
   pcb_t* next_proc = remove_from_queue(lock->blocked_queue);
-  TracePrintf(1, "RELEASE_LOCK: Passed queue remove %d\n", lock_id);
 
   if (next_proc != NULL) {
+    TracePrintf(1, "RELEASE_LOCK: Handing lock %d to process %d\n", lock_id, next_proc->pid);
     lock->locking_proc = next_proc;
     // put this process back into the ready queue
-    add_to_queue(ready_queue, next_proc);
+    add_ready(scheduler_global, next_proc);
   }
 
   TracePrintf(1, "RELEASE_LOCK: Finishing");
@@ -144,12 +168,34 @@ int release(int lock_id)
 }
 
 /*
- * Deletes the lock
+ * Wait morphing: a process woken from a cvar has to hold its lock again before it returns. Rather than waking
+ * it up to contend for the lock, give it the lock now if the lock is free; otherwise move it straight onto
+ * the lock's blocked queue, and release will hand it the lock. If the lock is gone, just wake the process up.
+ */
+void acquire_for_waiter(int lock_id, pcb_t* process)
+{
+  // a CvarTimedWait is over once signaled; waiting for the lock has no timeout
+  cancel_timer(timer_wheel_global, &process->delay_timer);
+  lock_t* lock = find_lock(lock_id);
+  if (lock == NULL || lock->locking_proc == NULL || lock->locking_proc == process) {
+    if (lock != NULL) {
+      lock->locking_proc = process;
+    }
+    add_ready(scheduler_global, process);
+    return;
+  }
+  TracePrintf(1, "ACQUIRE_LOCK: Moving cvar waiter %d onto the queue for lock %d\n", process->pid, lock_id);
+  add_to_queue(lock->blocked_queue, process);
+}
+
+/*
+ * Takes the lock out of the lock table and deletes it
  */
 int delete_lock(lock_t* lock) {
   if (lock != NULL) {
-    free(lock->blocked_queue);
+    id_table_remove(lock_table, lock->lock_id);
+    delete_queue(lock->blocked_queue);
   }
-  free(lock);
+  slab_free(lock_cache, lock);
   return SUCCESS;
 }
\ No newline at end of file
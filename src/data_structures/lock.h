@@ -9,8 +9,6 @@ typedef struct lock{
   bool locked;
   pcb_t* locking_proc;
   queue_t* blocked_queue;
-  struct lock* next_lock;
-  struct lock* prev_lock;
 } lock_t;
 
 /*
@@ -19,12 +17,12 @@ typedef struct lock{
 lock_t* create_lock(int lock_id);
 
 /*
- * Creates a lock with any id
+ * Creates a lock with the next free id and puts it in the lock table
  */
 lock_t* create_lock_any_id();
 
 /*
- * Finds the lock in the linked list of locks
+ * Finds the lock in the lock table
  */
 lock_t* find_lock(int lock_id);
 
@@ -39,6 +37,12 @@ lock_t* create_lock(int lock_id);
  */
 int acquire(int lock_id);
 
+/*
+ * Attempts to acquire a lock with this id, giving up after ticks clock ticks (or straight away if ticks is 0)
+ * returns ERROR in event of error, TIMED_OUT if the lock didn't come free in time, SUCCESS otherwise
+ */
+int acquire_timeout(int lock_id, int ticks);
+
 /*
  * Attempts to release a lock with this id
  * ERROR if lock doesn't exist, this process does not possess lock
@@ -47,7 +51,13 @@ int acquire(int lock_id);
 int release(int lock_id);
 
 /*
- * Deletes the lock
+ * Gives a process woken from a cvar its lock back: the lock if it is free (and the process is made ready),
+ * or a place on the lock's blocked queue if it isn't
+ */
+void acquire_for_waiter(int lock_id, pcb_t* process);
+
+/*
+ * Takes the lock out of the lock table and deletes it
  */
 int delete_lock(lock_t* lock);
 
@@ -1,50 +1,58 @@
 #include <ykernel.h>
 #include "pcb.h"
+#include "slab.h"
+#include "../process_management/scheduler.h"
+#include "../syscalls/custom_syscalls.h"
+
+// everything allocate_pcb hands out, in one slab object: the pcb and the per-process tables it points into
+typedef struct pcb_block {
+  pcb_t pcb;
+  pte_t kernel_stack[KERNEL_STACK_MAXSIZE >> PAGESHIFT];
+  pte_t region_1_page_table[UP_TO_PAGE(VMEM_1_SIZE) >> PAGESHIFT];
+  unsigned char page_flags[UP_TO_PAGE(VMEM_1_SIZE) >> PAGESHIFT];
+  UserContext uctxt;
+  KernelContext kctxt;
+} pcb_block_t;
+
+static slab_cache_t *pcb_cache = NULL;
+
+/*
+* Constructor for pcb slab objects: point the pcb at its own tables, with no kernel stack
+*/
+static void construct_pcb_block(void *object) {
+  pcb_block_t *block = (pcb_block_t *) object;
+  block->pcb.kernel_stack = block->kernel_stack;
+  block->pcb.region_1_page_table = block->region_1_page_table;
+  block->pcb.page_flags = block->page_flags;
+  block->pcb.uctxt = &block->uctxt;
+  block->pcb.kctxt = &block->kctxt;
+  bzero(block->kernel_stack, sizeof(block->kernel_stack));
+}
 
 /*
 * Allocate pcb data structures; e.g. kernel context and stack
-* If we encounter an error, we fail atomically and return NULL after freeing any allocated structures.
+* The pcb and all its tables come from a single slab object. Returns NULL if we are out of kernel heap.
 */
 pcb_t *allocate_pcb() {
-  int num_stack_pages = KERNEL_STACK_MAXSIZE >> PAGESHIFT;
-  int reg_1_page_table_size = UP_TO_PAGE(VMEM_1_SIZE) >> PAGESHIFT;
-  pcb_t *pcb = malloc(sizeof(pcb_t));
-  if (pcb == NULL) {
-    TracePrintf(1, "Failed to allocate memory for a new pcb\n");
-    return NULL;
-  }
-  pcb -> kernel_stack = malloc(num_stack_pages * sizeof(pte_t));
-  if (pcb->kernel_stack == NULL) {
-    TracePrintf(1, "Failed to allocate memory for a new pcb's kernel stack\n");
-    free(pcb);
-    return NULL;
-  }
-  pcb -> region_1_page_table = malloc(reg_1_page_table_size * sizeof(pte_t));
-  if (pcb->region_1_page_table == NULL) {
-    TracePrintf(1, "Failed to allocate memory for a new pcb's region 1 page table\n");
-    free(pcb->kernel_stack);
-    free(pcb);
-    return NULL;
-  }
-  pcb -> uctxt = malloc(sizeof(UserContext));
-  if (pcb->uctxt == NULL) {
-    TracePrintf(1, "Failed to allocate memory for a new pcb's user context\n");
-    free(pcb->region_1_page_table);
-    free(pcb->kernel_stack);
-    free(pcb);
-    return NULL;
+  if (pcb_cache == NULL) {
+    pcb_cache = create_slab_cache("pcb", sizeof(pcb_block_t), &construct_pcb_block);
+    if (pcb_cache == NULL) {
+      return NULL;
+    }
   }
-  pcb -> kctxt = malloc(sizeof(KernelContext));
-  if (pcb->kctxt == NULL) {
-    TracePrintf(1, "Failed to allocate memory for a new pcb's kernel context\n");
-    free(pcb->uctxt);
-    free(pcb->region_1_page_table);
-    free(pcb->kernel_stack);
-    free(pcb);
+  pcb_block_t *block = slab_alloc(pcb_cache);
+  if (block == NULL) {
+    TracePrintf(1, "Failed to allocate memory for a new pcb\n");
     return NULL;
   }
+  pcb_t *pcb = &block->pcb;
+  // the kernel stack is already empty (see free_pcb); region 1 starts out with nothing mapped
+  bzero(block->region_1_page_table, sizeof(block->region_1_page_table));
+  bzero(block->page_flags, sizeof(block->page_flags));
 
   pcb->brk_floor = 0;
+  pcb->image = NULL;
+  pcb->parent = NULL;
   pcb->children = NULL;
   pcb->next_pcb = NULL;
   pcb->prev_pcb = NULL;
@@ -52,9 +60,43 @@ pcb_t *allocate_pcb() {
   pcb->prev_sibling = NULL;
   pcb->hasExited = false;
   pcb->waitingForChildExit = false;
+  pcb->vfork_parent = NULL;
+  pcb->waitingForVforkChild = false;
+  init_timer(&pcb->delay_timer, NULL, pcb);
+  pcb->timed_wait_queue = NULL;
+  pcb->wait_timed_out = false;
+  pcb->sched_level = 0;
+  pcb->ticks_used = 0;
+  set_priority(pcb, PRIORITY_DEFAULT);
   return pcb;
 }
 
+/*
+* Point a pcb back at its own (empty) region 1 page table and page flags, e.g. when a VFork child stops
+* borrowing its parent's
+*/
+void use_own_region_1(pcb_t *pcb) {
+  pcb_block_t *block = (pcb_block_t *) pcb;
+  bzero(block->region_1_page_table, sizeof(block->region_1_page_table));
+  bzero(block->page_flags, sizeof(block->page_flags));
+  pcb->region_1_page_table = block->region_1_page_table;
+  pcb->page_flags = block->page_flags;
+}
+
+/*
+* Return a pcb to the pcb cache. The caller must already have given back anything it refers to (frames,
+* the kernel stack, the exec image); we restore the table pointers the constructor set up.
+*/
+void free_pcb(pcb_t *pcb) {
+  pcb_block_t *block = (pcb_block_t *) pcb;
+  pcb->kernel_stack = block->kernel_stack;
+  pcb->region_1_page_table = block->region_1_page_table;
+  pcb->page_flags = block->page_flags;
+  pcb->uctxt = &block->uctxt;
+  pcb->kctxt = &block->kctxt;
+  slab_free(pcb_cache, block);
+}
+
 /*
 * Set pcb values
 */
@@ -3,13 +3,26 @@
 
 #include <ykernel.h>
 #include "stdbool.h"
+#include "timer_wheel.h"
+
+// per-page software flags kept alongside the region 1 page table
+#define PAGE_FLAG_COW 0x1                              // page is shared copy-on-write; writes must copy it first
+#define PAGE_FLAG_FILE 0x2                             // page is invalid until loaded from the process's exec image
+#define PAGE_FLAG_SHARED 0x4                           // page stays shared and writable with forked children (SharePages)
+
+struct exec_image;
 
 /*
 * Our pcb stores the following types of info:
 * 0. PID
 * 1. Page table info and contexts
 *     We need to store the user page table. Because the kernel page table
-*     doesn't move, we simply store the new kernel stack.
+*     doesn't move, we simply store the new kernel stack. Software-only state for
+*     each region 1 page (e.g. copy-on-write) lives in page_flags, since the
+*     hardware pte has no room for it. Pages still to be loaded from the
+*     executable point at the process's exec image. A VFork child has no
+*     region 1 of its own: its table, flags and image are its parent's until it
+*     execs or exits.
 * 2. Contexts
 *     We store both user and kernel contexts. 
 * 3. Proc Death Info
@@ -23,6 +36,8 @@ typedef struct pcb {
   int pid;
   pte_t *kernel_stack;
   pte_t *region_1_page_table;
+  unsigned char *page_flags;                           // PAGE_FLAG_* bits for each region 1 page
+  struct exec_image *image;                            // where PAGE_FLAG_FILE pages come from (NULL if none)
   UserContext *uctxt;
   KernelContext *kctxt;
 
@@ -38,14 +53,35 @@ typedef struct pcb {
   struct pcb *prev_sibling;                            // null unless there are other siblings
   int num_children;                                    // 0 unless there are children
   struct pcb *parent;                                       // the parent, if any
-  int delayed_clock_cycles;                            // 0 unless it is delayed
+  struct pcb *vfork_parent;                            // while a VFork child runs in its parent's address space, that parent
+  bool waitingForVforkChild;                           // whether this pcb has lent its address space to a VFork child
+  tick_timer_t delay_timer;                            // armed on the timer wheel while the process is in Delay or a timed wait
+  int sched_level;                                     // the scheduler level it is on (always 0 under round robin)
+  int ticks_used;                                      // clock ticks it has run since it was last made ready
+  int priority;                                        // PRIORITY_HIGHEST..PRIORITY_LOWEST, set with SetPriority
+  int quantum;                                         // clock ticks it may run per turn (before any MLFQ scaling)
+  int turns_passed;                                    // times it let another ready process go first since it last ran
+  int cvar_lock_id;                                    // while it waits on a cvar, the lock it gets back on wakeup
+  struct queue *timed_wait_queue;                      // the queue a timed wait is blocked on, for delay_timer to take it off
+  bool wait_timed_out;                                 // whether its last timed wait ran out of ticks
 } pcb_t;
 
 /*
-* Allocate pcb data structures; e.g. kernel context and stack
+* Allocate pcb data structures; e.g. kernel context and stack.
+* The pcb, its kernel stack and region 1 page tables, page flags and contexts are one slab object.
 */
 pcb_t *allocate_pcb();
 
+/*
+* Point a pcb back at its own empty region 1 page table and page flags
+*/
+void use_own_region_1(pcb_t *pcb);
+
+/*
+* Return a pcb to the pcb cache, once everything it refers to has been released
+*/
+void free_pcb(pcb_t *pcb);
+
 /*
 * Set pcb values
 */
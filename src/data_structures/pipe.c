@@ -4,38 +4,71 @@
 #include "../syscalls/sync_syscalls.h"
 #include <ykernel.h>
 #include <yalnix.h>
+#include "slab.h"
+#include "../syscalls/custom_syscalls.h"
+#include "../memory/cow.h"
+
+static slab_cache_t *pipe_cache = NULL;
+static slab_cache_t *pipe_page_cache = NULL;
 
 /****************** UTILITY FUNCTIONS ***********************/
 
 /*
- * Creates a new pipe with this id
+ * Creates a new pipe holding up to capacity bytes with the next free id, and puts it in the pipe table
  */
-pipe_t* create_pipe(int pipe_id)
+pipe_t* create_pipe(int capacity)
 {
-  pipe_t* pipe_obj = malloc(sizeof (pipe_t));
+  if (pipe_cache == NULL) {
+    pipe_cache = create_slab_cache("pipe", sizeof(pipe_t), NULL);
+    if (pipe_cache == NULL) {
+      return NULL;
+    }
+  }
+  pipe_t* pipe_obj = slab_alloc(pipe_cache);
 
   if (pipe_obj == NULL) {
     TracePrintf(1, "CREATE_PIPE: Failed to allocate space for the pipe object\n");
     return NULL;
   }
 
-  pipe_obj->pipe_id = pipe_id;
+  pipe_obj->buf = malloc(capacity);
   pipe_obj->blocked_read_queue = create_queue();
   pipe_obj->blocked_write_queue = create_queue();
   pipe_obj->start_id = 0;
   pipe_obj->end_id = 0;
-  pipe_obj->max_size = PIPE_BUFFER_LEN;
+  pipe_obj->max_size = capacity;
   pipe_obj->cur_size = 0;
-  pipe_obj->prev_pipe = NULL;
-  pipe_obj->next_pipe = NULL;
+  pipe_obj->ring_bytes_written = 0;
+  pipe_obj->ring_bytes_read = 0;
+  pipe_obj->pages_head = NULL;
+  pipe_obj->pages_tail = NULL;
+  pipe_obj->num_pages = 0;
+  pipe_obj->page_offset = 0;
   pipe_obj->read_lock = create_lock_any_id();
   pipe_obj->write_lock = create_lock_any_id();
 
-  if (pipe_obj->blocked_read_queue == NULL || pipe_obj->blocked_write_queue == NULL ||
+  if (pipe_obj->buf == NULL || pipe_obj->blocked_read_queue == NULL || pipe_obj->blocked_write_queue == NULL ||
       pipe_obj->read_lock == NULL || pipe_obj->write_lock == NULL
   ) {
     TracePrintf(1, "CREATE_PIPE: One of the malloc-d objects is NULL\n");
-    free(pipe_obj);
+    free(pipe_obj->buf);
+    delete_queue(pipe_obj->blocked_read_queue);
+    delete_queue(pipe_obj->blocked_write_queue);
+    delete_lock(pipe_obj->read_lock);
+    delete_lock(pipe_obj->write_lock);
+    slab_free(pipe_cache, pipe_obj);
+    return NULL;
+  }
+
+  pipe_obj->pipe_id = id_table_insert(pipe_table, pipe_obj);
+  if (pipe_obj->pipe_id == ERROR) {
+    TracePrintf(1, "CREATE_PIPE: Run out of ID space to allocate more pipes\n");
+    free(pipe_obj->buf);
+    delete_queue(pipe_obj->blocked_read_queue);
+    delete_queue(pipe_obj->blocked_write_queue);
+    delete_lock(pipe_obj->read_lock);
+    delete_lock(pipe_obj->write_lock);
+    slab_free(pipe_cache, pipe_obj);
     return NULL;
   }
 
@@ -47,13 +80,45 @@ pipe_t* create_pipe(int pipe_id)
  */
 pipe_t* find_pipe(int pipe_id)
 {
-  pipe_t* next_pipe = pipes;
-  while (next_pipe != NULL) {
-    if (next_pipe->pipe_id == pipe_id) {
-      return next_pipe;
-    }
+  return id_table_find(pipe_table, pipe_id);
+}
+
+/*
+ * Rounds a requested capacity up to whole pages. This only sizes the buffer: it comes from malloc, so it isn't
+ * page-aligned and doesn't get frames of its own.
+ */
+int round_pipe_capacity(int bytes)
+{
+  if (bytes <= 0 || bytes > PIPE_MAX_CAPACITY) {
+    return ERROR;
+  }
+  return UP_TO_PAGE(bytes);
+}
+
+/*
+ * Moves the pipe's contents to the front of a new buffer of capacity bytes. Nothing keeps pointers into the
+ * buffer across a block, so this is safe even while readers or writers are blocked on the pipe.
+ */
+int resize_pipe(pipe_t* pipe, int capacity)
+{
+  if (capacity < pipe->cur_size) {
+    TracePrintf(1, "RESIZE_PIPE: Pipe %d holds %d bytes, more than %d\n", pipe->pipe_id, pipe->cur_size, capacity);
+    return ERROR;
+  }
+  char* new_buf = malloc(capacity);
+  if (new_buf == NULL) {
+    TracePrintf(1, "RESIZE_PIPE: Unable to allocate %d bytes for pipe %d\n", capacity, pipe->pipe_id);
+    return ERROR;
   }
-  return NULL;
+
+  int num_bytes = pipe_read_bytes(pipe, new_buf, pipe->cur_size);
+  free(pipe->buf);
+  pipe->buf = new_buf;
+  pipe->max_size = capacity;
+  pipe->start_id = 0;
+  pipe->end_id = (num_bytes == capacity) ? 0 : num_bytes;
+  pipe->cur_size = num_bytes;
+  return SUCCESS;
 }
 
 bool is_full(pipe_t* pipe)
@@ -67,47 +132,211 @@ bool is_full(pipe_t* pipe)
 
 bool pipe_is_empty(pipe_t* pipe)
 {
-  // check to see if the pipe is empty
-  if (pipe->cur_size == 0) {
+  // check to see if the pipe is empty, flipped pages included
+  if (pipe->cur_size == 0 && pipe->pages_head == NULL) {
     return true;
   }
   return false;
 }
 
-char read_byte(pipe_t* pipe)
+/*
+ * Copies up to len bytes out of the pipe. The unread bytes run from start_id, possibly wrapping around the end of
+ * the ring buffer, so this is at most two memcpys: up to the end of the buffer, then from its front.
+ */
+int pipe_read_bytes(pipe_t* pipe, char* buf, int len)
 {
-  // returns ERROR if there is no byte to read (is_empty)
-  if (pipe_is_empty(pipe)) {
-    return ERROR;
+  int num_bytes = (len < pipe->cur_size) ? len : pipe->cur_size;
+  int first_len = pipe->max_size - pipe->start_id;
+  if (first_len > num_bytes) {
+    first_len = num_bytes;
   }
+  memcpy(buf, pipe->buf + pipe->start_id, first_len);
+  memcpy(buf + first_len, pipe->buf, num_bytes - first_len);
 
-  // reads a byte from the start_index of the buffer
-  char byte = pipe->buf[pipe->start_id];
+  pipe->start_id += num_bytes;
+  if (pipe->start_id >= pipe->max_size) {
+    pipe->start_id -= pipe->max_size;
+  }
+  pipe->cur_size -= num_bytes;
+  return num_bytes;
+}
 
-  // increments the start_index (rolls around if we exceed buf_size)
-  pipe->start_id = (pipe->start_id + 1) % pipe->max_size;
-  pipe->cur_size--;
+/*
+ * Copies up to len bytes onto the end of the pipe, which starts at end_id: again at most two memcpys, up to the end
+ * of the ring buffer and then from its front.
+ */
+int pipe_write_bytes(pipe_t* pipe, const char* buf, int len)
+{
+  int free_space = pipe->max_size - pipe->cur_size;
+  int num_bytes = (len < free_space) ? len : free_space;
+  int first_len = pipe->max_size - pipe->end_id;
+  if (first_len > num_bytes) {
+    first_len = num_bytes;
+  }
+  memcpy(pipe->buf + pipe->end_id, buf, first_len);
+  memcpy(pipe->buf, buf + first_len, num_bytes - first_len);
 
-  // returns the byte
-  return byte;
+  pipe->end_id += num_bytes;
+  if (pipe->end_id >= pipe->max_size) {
+    pipe->end_id -= pipe->max_size;
+  }
+  pipe->cur_size += num_bytes;
+  return num_bytes;
 }
 
-int write_byte(pipe_t* pipe, char byte)
+/*
+ * Flips the whole pages at the start of the len bytes at buf onto the end of the page queue. Each page is
+ * write-protected in the writer, so the reader gets the bytes as they were written even if the writer scribbles on
+ * its buffer afterwards. Returns the number of bytes flipped: 0 if buf isn't page-aligned, and short of len at a
+ * PAGE_FLAG_SHARED page (other processes can still write its frame) or once the queue is full.
+ */
+static int write_pipe_pages(pipe_t* pipe, char* buf, int len)
 {
-  // returns ERROR if there is no more space in the buffer (is_full)
-  if (is_full(pipe)) {
-    return ERROR;
+  if (((int) buf & PAGEOFFSET) != 0) {
+    return 0;
+  }
+  if (pipe_page_cache == NULL) {
+    pipe_page_cache = create_slab_cache("pipe_page", sizeof(pipe_page_t), NULL);
+    if (pipe_page_cache == NULL) {
+      return 0;
+    }
   }
 
-  // writes a byte at the end_index of the buffer
-  pipe->buf[pipe->end_id] = byte;
+  int num_bytes = 0;
+  while (len - num_bytes >= PAGESIZE && pipe->num_pages < PIPE_MAX_FLIPPED_PAGES) {
+    int page = ((int) buf + num_bytes - VMEM_1_BASE) >> PAGESHIFT;
+    if (running_process->page_flags[page] & PAGE_FLAG_SHARED) {
+      break;
+    }
+    pipe_page_t* pipe_page = slab_alloc(pipe_page_cache);
+    if (pipe_page == NULL) {
+      break;
+    }
+    pipe_page->pfn = share_frame_cow(running_process, page);
+    pipe_page->ring_pos = pipe->ring_bytes_written;
+    pipe_page->next = NULL;
+    if (pipe->pages_tail == NULL) {
+      pipe->pages_head = pipe_page;
+    }
+    else {
+      pipe->pages_tail->next = pipe_page;
+    }
+    pipe->pages_tail = pipe_page;
+    pipe->num_pages++;
+    num_bytes += PAGESIZE;
+  }
+  return num_bytes;
+}
 
-  // increments the end_index (rolls around if necessary)
-  pipe->end_id = (pipe->end_id + 1) % pipe->max_size;
-  pipe->cur_size++;
+/*
+ * Takes the head page off the page queue, along with the pipe's reference to its frame if release is set
+ */
+static void pop_pipe_page(pipe_t* pipe, bool release)
+{
+  pipe_page_t* pipe_page = pipe->pages_head;
+  pipe->pages_head = pipe_page->next;
+  if (pipe->pages_head == NULL) {
+    pipe->pages_tail = NULL;
+  }
+  pipe->num_pages--;
+  pipe->page_offset = 0;
+  if (release) {
+    release_frame(frame_table_global, pipe_page->pfn);
+  }
+  slab_free(pipe_page_cache, pipe_page);
+}
 
-  // returns 0
-  return SUCCESS;
+/*
+ * Moves up to len bytes of the head page into buf. If buf is page-aligned and takes the whole unread page, the frame
+ * itself is mapped there in place of buf's own (copy-on-write while the writer still maps it); otherwise the bytes
+ * are copied out through the buffer page. Returns the number of bytes moved.
+ */
+static int read_pipe_page(pipe_t* pipe, char* buf, int len)
+{
+  if (pipe->pages_head == NULL) {
+    return 0;
+  }
+  int page = ((int) buf - VMEM_1_BASE) >> PAGESHIFT;
+  if (pipe->page_offset == 0 && ((int) buf & PAGEOFFSET) == 0 && len >= PAGESIZE &&
+      !(running_process->page_flags[page] & PAGE_FLAG_SHARED)) {
+    map_frame_cow(running_process, page, pipe->pages_head->pfn);
+    pop_pipe_page(pipe, false);
+    return PAGESIZE;
+  }
+
+  int num_bytes = PAGESIZE - pipe->page_offset;
+  if (num_bytes > len) {
+    num_bytes = len;
+  }
+  copy_from_frame(pipe->pages_head->pfn, pipe->page_offset, buf, num_bytes);
+  pipe->page_offset += num_bytes;
+  if (pipe->page_offset == PAGESIZE) {
+    pop_pipe_page(pipe, true);
+  }
+  return num_bytes;
+}
+
+/*
+ * Reads the ring buffer's bytes up to the next flipped page, then the page, and so on until len bytes are read or
+ * the pipe is empty
+ */
+int pipe_read(pipe_t* pipe, char* buf, int len)
+{
+  int num_read = 0;
+  while (num_read < len) {
+    int num_bytes;
+    int ring_len = pipe->cur_size;
+    if (pipe->pages_head != NULL) {
+      ring_len = pipe->pages_head->ring_pos - pipe->ring_bytes_read;
+    }
+
+    if (ring_len > 0) {
+      num_bytes = pipe_read_bytes(pipe, buf + num_read, (len - num_read < ring_len) ? len - num_read : ring_len);
+      pipe->ring_bytes_read += num_bytes;
+    }
+    else {
+      num_bytes = read_pipe_page(pipe, buf + num_read, len - num_read);
+    }
+    if (num_bytes == 0) {
+      break;
+    }
+    num_read += num_bytes;
+  }
+  return num_read;
+}
+
+/*
+ * Flips whatever whole pages it can and copies the rest into the ring buffer. An unaligned buf is copied up to its
+ * next page boundary first, so that the pages after it can be flipped.
+ */
+int pipe_write(pipe_t* pipe, char* buf, int len)
+{
+  int num_written = 0;
+  while (num_written < len) {
+    char* pos = buf + num_written;
+    int num_bytes = write_pipe_pages(pipe, pos, len - num_written);
+
+    if (num_bytes == 0) {
+      int copy_len = len - num_written;
+      int head_len = (int) UP_TO_PAGE(pos) - (int) pos;
+      if (head_len > 0 && copy_len - head_len >= PAGESIZE) {
+        copy_len = head_len;
+      }
+      else if (head_len == 0 && copy_len > PAGESIZE) {
+        // an aligned page we couldn't flip
+        copy_len = PAGESIZE;
+      }
+      num_bytes = pipe_write_bytes(pipe, pos, copy_len);
+      pipe->ring_bytes_written += num_bytes;
+    }
+    if (num_bytes == 0) {
+      break;
+    }
+    num_written += num_bytes;
+  }
+  TracePrintf(5, "PIPE_WRITE: Moved %d bytes into pipe %d, which holds %d flipped pages\n",
+              num_written, pipe->pipe_id, pipe->num_pages);
+  return num_written;
 }
 
 int block_pcb_on_pipe_read(pipe_t* pipe, pcb_t* process_block)
@@ -133,7 +362,7 @@ pcb_t* unblock_pcb_on_pipe_read(pipe_t* pipe)
 
   if (next_pcb != NULL) {
     // adds the pcb to the ready queue
-    add_to_queue(ready_queue, next_pcb);
+    add_ready(scheduler_global, next_pcb);
   }
   // returns the pcb
   return next_pcb;
@@ -150,19 +379,27 @@ pcb_t* unblock_pcb_on_pipe_write(pipe_t* pipe)
 
   if (next_pcb != NULL) {
     // adds the pcb to the ready queue
-    add_to_queue(ready_queue, next_pcb);
+    add_ready(scheduler_global, next_pcb);
   }
   // returns the pcb
   return next_pcb;
 }
 
+/*
+ * Takes the pipe out of the pipe table and deletes it, along with its locks
+ */
 void delete_pipe(pipe_t* pipe)
 {
-  free(pipe->blocked_write_queue);
-  free(pipe->blocked_write_queue);
+  id_table_remove(pipe_table, pipe->pipe_id);
+  delete_queue(pipe->blocked_read_queue);
+  delete_queue(pipe->blocked_write_queue);
   handle_LockKill(pipe->read_lock->lock_id, 1);
   handle_LockKill(pipe->write_lock->lock_id, 1);
-  free(pipe);
+  while (pipe->pages_head != NULL) {
+    pop_pipe_page(pipe, true);
+  }
+  free(pipe->buf);
+  slab_free(pipe_cache, pipe);
 }
 
 /***************** END UTILITY FUNCTIONS *********************/
\ No newline at end of file
@@ -9,15 +9,27 @@
 #include "lock.h"
 #include <yalnix.h>
 
+#define PIPE_MAX_FLIPPED_PAGES 16        // how many whole pages a pipe holds on to for large writes
+
+typedef struct pipe_page {
+  int pfn;                                 // a writer's frame, which the pipe holds a reference on
+  unsigned int ring_pos;                   // ring_bytes_written when the page went in; those bytes are read first
+  struct pipe_page* next;
+} pipe_page_t;
+
 typedef struct pipe {
   int pipe_id;
-  char buf[PIPE_BUFFER_LEN];
+  char* buf;                               // the ring buffer, malloc-ed; a multiple of PAGESIZE for a sized pipe
   int start_id;
   int end_id;
-  int max_size;
+  int max_size;                            // the capacity of buf
   int cur_size;
-  struct pipe* prev_pipe;                  // the previous pipe in the global pipe list
-  struct pipe* next_pipe;                  // the next pipe in the global pipe list
+  unsigned int ring_bytes_written;         // running totals of bytes through buf, to place flipped pages among them
+  unsigned int ring_bytes_read;
+  pipe_page_t* pages_head;                 // whole pages flipped in by large writes, oldest first
+  pipe_page_t* pages_tail;
+  int num_pages;
+  int page_offset;                         // how much of the head page has already been read
   lock_t* read_lock;                       // the lock for reading this pipe
   queue_t* blocked_read_queue;             // the queue of processes blocked on reads on this pipe
   lock_t* write_lock;                      // the lock for writing this pipe
@@ -25,29 +37,65 @@ typedef struct pipe {
 } pipe_t;
 
 /*
- * Creates a new pipe with this id
+ * Creates a new pipe holding up to capacity bytes with the next free id, and puts it in the pipe table
+ */
+pipe_t* create_pipe(int capacity);
+
+/*
+ * Rounds a requested capacity up to a multiple of PAGESIZE; the buffer is still malloc-ed, not page-aligned.
+ * Returns ERROR if it is out of range (1..PIPE_MAX_CAPACITY).
  */
-pipe_t* create_pipe(int pipe_id);
+int round_pipe_capacity(int bytes);
 
+/*
+ * Moves the pipe's contents into a new buffer of capacity bytes. Returns ERROR if they wouldn't fit, or if we are out
+ * of kernel memory (in which case the pipe is left as it was).
+ */
+int resize_pipe(pipe_t* pipe, int capacity);
+
+/*
+ * Returns the pipe with this ID, else NULL
+ */
 pipe_t* find_pipe(int pipe_id);
 
 bool is_full(pipe_t* pipe);
 
 bool pipe_is_empty(pipe_t* pipe);
 
-char read_byte(pipe_t* pipe);
+/*
+ * Copies up to len bytes out of the pipe into buf, oldest first. Returns the number of bytes copied, which is less
+ * than len if the pipe didn't hold that many.
+ */
+int pipe_read_bytes(pipe_t* pipe, char* buf, int len);
+
+/*
+ * Copies up to len bytes from buf onto the end of the pipe. Returns the number of bytes copied, which is less than
+ * len if the pipe didn't have room for them all.
+ */
+int pipe_write_bytes(pipe_t* pipe, const char* buf, int len);
 
-int write_byte(pipe_t* pipe, char byte);
+/*
+ * Moves up to len bytes out of the pipe into buf, in the order they were written. Whole unread pages land in a
+ * page-aligned buf without being copied. Returns the number of bytes moved, less than len if the pipe ran out.
+ */
+int pipe_read(pipe_t* pipe, char* buf, int len);
+
+/*
+ * Moves as much of the len bytes at buf, region 1 memory of the running process, onto the end of the pipe as it has
+ * room for. Whole pages of buf are flipped into the pipe copy-on-write instead of being copied into the ring buffer.
+ * Returns the number of bytes moved, which is 0 if the pipe is full.
+ */
+int pipe_write(pipe_t* pipe, char* buf, int len);
 
 int block_pcb_on_pipe_read(pipe_t* pipe, pcb_t* process_block);
 
 int block_pcb_on_pipe_write(pipe_t* pipe, pcb_t* process_block);
 
-/********** unblock_pcb_on_pipe *************/
+/********** unblock_pcb_on_pipe_read *************/
 /*
  * Gets the pcb_t* at head of pipe, places it in ready queue, returns a pointer to it
  */
-pcb_t* unblock_pcb_on_pipe(pipe_t* pipe);
+pcb_t* unblock_pcb_on_pipe_read(pipe_t* pipe);
 
 /********** unblock_pcb_on_pipe_write *************/
 /*
@@ -55,6 +103,9 @@ pcb_t* unblock_pcb_on_pipe(pipe_t* pipe);
  */
 pcb_t* unblock_pcb_on_pipe_write(pipe_t* pipe);
 
+/*
+ * Takes the pipe out of the pipe table and deletes it, along with its locks and any pages it still holds
+ */
 void delete_pipe(pipe_t* pipe);
 
 #endif //CURRENT_CHUNGUS_PIPE
\ No newline at end of file
@@ -1,21 +1,47 @@
 #include <ykernel.h>
 #include "queue.h"
 #include "pcb.h"
+#include "slab.h"
 
+static slab_cache_t *queue_cache = NULL;
 
+/*
+ * Constructor for queue slab objects: an empty queue
+ */
+static void construct_queue(void *object) {
+  queue_t* queue = (queue_t *) object;
+  queue->size = 0;
+  queue->head = NULL;
+  queue->tail = NULL;
+}
 
 /*
  * Creates a new queue object
  */
 queue_t* create_queue() {
-  queue_t* new_queue = malloc(sizeof (queue_t));
+  if (queue_cache == NULL) {
+    queue_cache = create_slab_cache("queue", sizeof(queue_t), &construct_queue);
+    if (queue_cache == NULL) {
+      return NULL;
+    }
+  }
+  queue_t* new_queue = slab_alloc(queue_cache);
   if (new_queue == NULL) {
     TracePrintf(1, "CREATE_QUEUE: Failed to allocate memory for a new queue\n");
     return NULL;
   }
-  new_queue->size = 0;
-  new_queue->head = NULL;
-  new_queue->tail = NULL;
+  return new_queue;
+}
+
+/*
+ * Frees a queue object. Anything still on it is forgotten (not freed).
+ */
+void delete_queue(queue_t* queue) {
+  if (queue == NULL) {
+    return;
+  }
+  construct_queue(queue);
+  slab_free(queue_cache, queue);
 }
 
 /*
@@ -82,4 +108,35 @@ pcb_t* remove_from_queue(queue_t* queue)
 
   // return the PCB
   return pcb;
-}
\ No newline at end of file
+}
+
+/*
+ * Removes a particular PCB from wherever it is in the queue. Like remove_from_queue, we go by the size: only the
+ * next_pcb links of the first size PCBs from the head are meaningful, so we walk those.
+ */
+bool remove_pcb_from_queue(queue_t* queue, pcb_t* pcb)
+{
+  pcb_t* prev = NULL;
+  pcb_t* curr = queue->head;
+  for (int i=0; i<queue->size && curr != NULL; i++) {
+    if (curr == pcb) {
+      if (prev == NULL) {
+        remove_from_queue(queue);
+        return true;
+      }
+      prev->next_pcb = curr->next_pcb;
+      if (queue->tail == curr) {
+        queue->tail = prev;
+      }
+      else {
+        curr->next_pcb->prev_pcb = prev;
+      }
+      queue->size--;
+      TracePrintf(1, "=========================REMOVING pcb %d\n", pcb->pid);
+      return true;
+    }
+    prev = curr;
+    curr = curr->next_pcb;
+  }
+  return false;
+}
@@ -19,6 +19,11 @@ typedef struct queue {
  */
 queue_t* create_queue();
 
+/*
+ * Frees a queue object
+ */
+void delete_queue(queue_t* queue);
+
 /*
  * is the queue empty?
  */
@@ -35,4 +40,10 @@ int add_to_queue(queue_t* queue, pcb_t* pcb);
  */
 pcb_t* remove_from_queue(queue_t* queue);
 
+/*
+ * Removes a particular PCB from wherever it is in the queue, e.g. a process whose wait timed out
+ * returns true if it was in the queue
+ */
+bool remove_pcb_from_queue(queue_t* queue, pcb_t* pcb);
+
 #endif //CURRENT_CHUNGUS_QUEUE
\ No newline at end of file
@@ -0,0 +1,173 @@
+#include <ykernel.h>
+#include "queue.h"
+#include "rwlock.h"
+#include "slab.h"
+#include "../kernel_start.h"
+
+static slab_cache_t *rwlock_cache = NULL;
+
+/*
+ * Creates a reader-writer lock with the next free id and puts it in the rwlock table
+ */
+rwlock_t* create_rwlock_any_id()
+{
+  if (rwlock_cache == NULL) {
+    rwlock_cache = create_slab_cache("rwlock", sizeof(rwlock_t), NULL);
+    if (rwlock_cache == NULL) {
+      return NULL;
+    }
+  }
+  rwlock_t* new_rwlock = slab_alloc(rwlock_cache);
+  if (new_rwlock == NULL) {
+    TracePrintf(1, "CREATE_RWLOCK: Failed to allocate memory for a new reader-writer lock\n");
+    return NULL;
+  }
+  new_rwlock->num_readers = 0;
+  new_rwlock->writer = NULL;
+  new_rwlock->read_queue = create_queue();
+  new_rwlock->write_queue = create_queue();
+  if (new_rwlock->read_queue == NULL || new_rwlock->write_queue == NULL) {
+    delete_queue(new_rwlock->read_queue);
+    delete_queue(new_rwlock->write_queue);
+    slab_free(rwlock_cache, new_rwlock);
+    return NULL;
+  }
+
+  int rwlock_id = id_table_insert(rwlock_table, new_rwlock);
+  if (rwlock_id == ERROR) {
+    TracePrintf(1, "CREATE_RWLOCK: Ran out of ID space to allocate more reader-writer locks\n");
+    delete_queue(new_rwlock->read_queue);
+    delete_queue(new_rwlock->write_queue);
+    slab_free(rwlock_cache, new_rwlock);
+    return NULL;
+  }
+  new_rwlock->id = rwlock_id;
+
+  return new_rwlock;
+}
+
+/*
+ * Finds the reader-writer lock in the rwlock table
+ */
+rwlock_t* find_rwlock(int rwlock_id)
+{
+  return id_table_find(rwlock_table, rwlock_id);
+}
+
+/*
+ * Acquires the reader-writer lock for reading. Readers wait behind a waiting writer as well as a holding one.
+ */
+int rw_acquire_read(int rwlock_id)
+{
+  rwlock_t* rwlock = find_rwlock(rwlock_id);
+  if (rwlock == NULL) {
+    TracePrintf(1, "RW_ACQUIRE_READ: The reader-writer lock with id %d does not exist\n", rwlock_id);
+    return ERROR;
+  }
+  if (rwlock->writer == running_process) {
+    TracePrintf(1, "RW_ACQUIRE_READ: Process %d already holds lock %d for writing\n", running_process->pid, rwlock_id);
+    return ERROR;
+  }
+
+  if (rwlock->writer == NULL && is_empty(rwlock->write_queue)) {
+    rwlock->num_readers++;
+    return SUCCESS;
+  }
+
+  // the releasing writer counts us in as a reader before waking us up
+  TracePrintf(1, "RW_ACQUIRE_READ: Process %d waiting to read lock %d\n", running_process->pid, rwlock_id);
+  add_to_queue(rwlock->read_queue, running_process);
+  install_next_from_queue(running_process, 1);
+  return (find_rwlock(rwlock_id) == rwlock) ? SUCCESS : ERROR;
+}
+
+/*
+ * Acquires the reader-writer lock for writing
+ */
+int rw_acquire_write(int rwlock_id)
+{
+  rwlock_t* rwlock = find_rwlock(rwlock_id);
+  if (rwlock == NULL) {
+    TracePrintf(1, "RW_ACQUIRE_WRITE: The reader-writer lock with id %d does not exist\n", rwlock_id);
+    return ERROR;
+  }
+  if (rwlock->writer == running_process) {
+    return SUCCESS;
+  }
+
+  if (rwlock->writer == NULL && rwlock->num_readers == 0) {
+    rwlock->writer = running_process;
+    return SUCCESS;
+  }
+
+  // whoever lets go of the lock last makes us the writer before waking us up
+  TracePrintf(1, "RW_ACQUIRE_WRITE: Process %d waiting to write lock %d\n", running_process->pid, rwlock_id);
+  add_to_queue(rwlock->write_queue, running_process);
+  install_next_from_queue(running_process, 1);
+  return (find_rwlock(rwlock_id) == rwlock) ? SUCCESS : ERROR;
+}
+
+/*
+ * Hands a lock nobody holds to the next waiting writer, or failing that to every waiting reader at once
+ */
+static void wake_rwlock_waiters(rwlock_t* rwlock)
+{
+  pcb_t* next_proc = remove_from_queue(rwlock->write_queue);
+  if (next_proc != NULL) {
+    TracePrintf(1, "RW_RELEASE: Handing lock %d to writer %d\n", rwlock->id, next_proc->pid);
+    rwlock->writer = next_proc;
+    add_ready(scheduler_global, next_proc);
+    return;
+  }
+
+  next_proc = remove_from_queue(rwlock->read_queue);
+  while (next_proc != NULL) {
+    rwlock->num_readers++;
+    add_ready(scheduler_global, next_proc);
+    next_proc = remove_from_queue(rwlock->read_queue);
+  }
+  TracePrintf(1, "RW_RELEASE: Let %d readers into lock %d\n", rwlock->num_readers, rwlock->id);
+}
+
+/*
+ * Releases the reader-writer lock. We don't keep track of which processes are reading, so any process that isn't
+ * the writer is taken to be one of the readers.
+ */
+int rw_release(int rwlock_id)
+{
+  rwlock_t* rwlock = find_rwlock(rwlock_id);
+  if (rwlock == NULL) {
+    TracePrintf(1, "RW_RELEASE: The reader-writer lock with id %d does not exist\n", rwlock_id);
+    return ERROR;
+  }
+
+  if (rwlock->writer == running_process) {
+    rwlock->writer = NULL;
+  }
+  else if (rwlock->writer == NULL && rwlock->num_readers > 0) {
+    rwlock->num_readers--;
+  }
+  else {
+    TracePrintf(1, "RW_RELEASE: The process with id %d doesn't hold the lock with id %d\n",
+                running_process->pid, rwlock_id);
+    return ERROR;
+  }
+
+  if (rwlock->writer == NULL && rwlock->num_readers == 0) {
+    wake_rwlock_waiters(rwlock);
+  }
+  return SUCCESS;
+}
+
+/*
+ * Takes the reader-writer lock out of the rwlock table and deletes it
+ */
+int delete_rwlock(rwlock_t* rwlock) {
+  if (rwlock != NULL) {
+    id_table_remove(rwlock_table, rwlock->id);
+    delete_queue(rwlock->read_queue);
+    delete_queue(rwlock->write_queue);
+  }
+  slab_free(rwlock_cache, rwlock);
+  return SUCCESS;
+}
@@ -0,0 +1,54 @@
+#ifndef CURRENT_CHUNGUS_RWLOCK_H
+#define CURRENT_CHUNGUS_RWLOCK_H
+
+#include <ykernel.h>
+#include "queue.h"
+
+/*
+ * A reader-writer lock: any number of readers, or a single writer. Writers get preference, so that a steady stream
+ * of readers can't keep a writer out: once a writer is waiting, new readers queue up behind it. Like locks, a
+ * process that has to wait is handed the lock before it is woken up, and all the waiting readers are let in as
+ * one batch once no writer holds or wants the lock.
+ */
+typedef struct rwlock {
+  int id;
+  int num_readers;                                   // processes holding the lock for reading
+  pcb_t* writer;                                     // the process holding the lock for writing, or NULL
+  queue_t* read_queue;                               // processes blocked in RwAcquireRead
+  queue_t* write_queue;                              // processes blocked in RwAcquireWrite
+} rwlock_t;
+
+/*
+ * Creates a reader-writer lock with the next free id and puts it in the rwlock table
+ */
+rwlock_t* create_rwlock_any_id();
+
+/*
+ * Finds the reader-writer lock in the rwlock table
+ */
+rwlock_t* find_rwlock(int rwlock_id);
+
+/*
+ * Acquires the reader-writer lock with this id for reading, blocking while a writer holds or is waiting for it
+ * returns ERROR in event of error, SUCCESS otherwise
+ */
+int rw_acquire_read(int rwlock_id);
+
+/*
+ * Acquires the reader-writer lock with this id for writing, blocking while anyone else holds it
+ * returns ERROR in event of error, SUCCESS otherwise
+ */
+int rw_acquire_write(int rwlock_id);
+
+/*
+ * Releases the reader-writer lock with this id, from writing if the process is its writer and from reading otherwise
+ * ERROR if the lock doesn't exist or the process can't be holding it; SUCCESS otherwise
+ */
+int rw_release(int rwlock_id);
+
+/*
+ * Takes the reader-writer lock out of the rwlock table and deletes it; we assume both queues to already be empty
+ */
+int delete_rwlock(rwlock_t* rwlock);
+
+#endif //CURRENT_CHUNGUS_RWLOCK_H
@@ -0,0 +1,63 @@
+#include <ykernel.h>
+#include "sem.h"
+#include "queue.h"
+#include "slab.h"
+#include "../kernel_start.h"
+
+static slab_cache_t *sem_cache = NULL;
+
+/*
+ * Create a semaphore with the next free id and the given value, and put it in the semaphore table
+ */
+semaphore_t* create_sem_any_id(int value)
+{
+  if (sem_cache == NULL) {
+    sem_cache = create_slab_cache("sem", sizeof(semaphore_t), NULL);
+    if (sem_cache == NULL) {
+      return NULL;
+    }
+  }
+  semaphore_t* new_sem = slab_alloc(sem_cache);
+  if (new_sem == NULL) {
+    TracePrintf(1, "CREATE_SEM: Failed to allocate memory for a new semaphore\n");
+    return NULL;
+  }
+  new_sem->value = value;
+  new_sem->blocked_queue = create_queue();
+  if (new_sem->blocked_queue == NULL) {
+    slab_free(sem_cache, new_sem);
+    return NULL;
+  }
+
+  int sem_id = id_table_insert(sem_table, new_sem);
+  if (sem_id == ERROR) {
+    TracePrintf(1, "CREATE_SEM: Ran out of space to allocate new semaphore ids\n");
+    delete_queue(new_sem->blocked_queue);
+    slab_free(sem_cache, new_sem);
+    return NULL;
+  }
+  new_sem->id = sem_id;
+
+  return new_sem;
+}
+
+/*
+ * Find a semaphore with the given id
+ */
+semaphore_t* find_sem(int sem_id)
+{
+  return id_table_find(sem_table, sem_id);
+}
+
+/*
+ * Take a semaphore out of the semaphore table and delete it; we assume blocked_queue to already be empty
+ */
+int delete_sem(semaphore_t* sem)
+{
+  if (sem != NULL) {
+    id_table_remove(sem_table, sem->id);
+    delete_queue(sem->blocked_queue);
+  }
+  slab_free(sem_cache, sem);
+  return SUCCESS;
+}
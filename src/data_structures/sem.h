@@ -0,0 +1,28 @@
+#ifndef CURRENT_CHUNGUS_SEM_H
+#define CURRENT_CHUNGUS_SEM_H
+
+#include <ykernel.h>
+#include "queue.h"
+
+typedef struct semaphore {
+  int id;
+  int value;                                         // units available; 0 whenever anyone is blocked
+  queue_t* blocked_queue;                            // processes blocked in SemDown, oldest first
+} semaphore_t;
+
+/*
+ * Create a semaphore with the next free id and the given value, and put it in the semaphore table
+ */
+semaphore_t* create_sem_any_id(int value);
+
+/*
+ * Find a semaphore with the given id
+ */
+semaphore_t* find_sem(int sem_id);
+
+/*
+ * Take a semaphore out of the semaphore table and delete it; we assume blocked_queue to already be empty
+ */
+int delete_sem(semaphore_t* sem);
+
+#endif //CURRENT_CHUNGUS_SEM_H
@@ -0,0 +1,86 @@
+#include <ykernel.h>
+#include "slab.h"
+
+//============================ SLAB HELPERS ==============================//
+/*
+* The free-list link kept just past an object
+*/
+static void **object_link(slab_cache_t *cache, void *object) {
+  return (void **) ((char *) object + cache->object_size);
+}
+
+/*
+* Take a new slab from the kernel heap, construct each of its objects and put them on the free list
+*/
+static int grow_slab_cache(slab_cache_t *cache) {
+  char *slab = malloc(cache->stride * cache->objects_per_slab);
+  if (slab == NULL) {
+    TracePrintf(1, "SLAB: Unable to allocate a new slab for the %s cache\n", cache->name);
+    return ERROR;
+  }
+  for (int i=0; i<cache->objects_per_slab; i++) {
+    void *object = slab + i * cache->stride;
+    if (cache->ctor != NULL) {
+      cache->ctor(object);
+    }
+    *object_link(cache, object) = cache->free_list;
+    cache->free_list = object;
+  }
+  cache->num_slabs++;
+  cache->num_free += cache->objects_per_slab;
+  TracePrintf(5, "SLAB: %s cache grew to %d slabs of %d objects\n", cache->name, cache->num_slabs,
+              cache->objects_per_slab);
+  return SUCCESS;
+}
+
+//============================ SLAB FUNCTIONS ==============================//
+/*
+* Create a cache of objects of object_size bytes
+*/
+slab_cache_t *create_slab_cache(char *name, int object_size, slab_ctor_t ctor) {
+  slab_cache_t *cache = malloc(sizeof(slab_cache_t));
+  if (cache == NULL) {
+    TracePrintf(1, "SLAB: Unable to allocate the %s cache\n", name);
+    return NULL;
+  }
+  cache->name = name;
+  cache->object_size = (object_size + sizeof(void *) - 1) & ~(sizeof(void *) - 1);
+  cache->stride = cache->object_size + sizeof(void *);
+  cache->objects_per_slab = SLAB_TARGET_SIZE / cache->stride;
+  if (cache->objects_per_slab < 1) {
+    cache->objects_per_slab = 1;
+  }
+  cache->ctor = ctor;
+  cache->free_list = NULL;
+  cache->num_slabs = 0;
+  cache->num_free = 0;
+  cache->num_in_use = 0;
+  return cache;
+}
+
+/*
+* Take a constructed object from the cache
+*/
+void *slab_alloc(slab_cache_t *cache) {
+  if (cache->free_list == NULL && grow_slab_cache(cache) == ERROR) {
+    return NULL;
+  }
+  void *object = cache->free_list;
+  cache->free_list = *object_link(cache, object);
+  cache->num_free--;
+  cache->num_in_use++;
+  return object;
+}
+
+/*
+* Give an object back to its cache
+*/
+void slab_free(slab_cache_t *cache, void *object) {
+  if (object == NULL) {
+    return;
+  }
+  *object_link(cache, object) = cache->free_list;
+  cache->free_list = object;
+  cache->num_free++;
+  cache->num_in_use--;
+}
@@ -0,0 +1,53 @@
+#ifndef CURRENT_CHUNGUS_SLAB_H
+#define CURRENT_CHUNGUS_SLAB_H
+
+#include <ykernel.h>
+
+#define SLAB_TARGET_SIZE PAGESIZE                      // how much kernel heap each slab asks malloc for
+
+/*
+* A slab cache hands out fixed-size kernel objects of one type (pcbs, locks, cvars, pipes, queues).
+*
+* Objects are carved out of slabs, each a single malloc of room for several objects, and freed objects go
+* onto the cache's free list rather than back to the kernel heap. Allocating and freeing are then a couple
+* of pointer moves, and the kernel heap (which only grows through SetKernelBrk) sees one request per slab
+* instead of one per syscall.
+*
+* If the cache has a constructor, it runs once on each object when its slab is created. Callers must hand
+* objects back in that constructed state, so the next slab_alloc can skip the work. The free list is
+* threaded through a link word after each object, so a free object's own bytes are left alone.
+*
+* Slabs are never given back to the heap.
+*/
+typedef void (*slab_ctor_t)(void *object);
+
+typedef struct slab_cache {
+  char *name;                                          // for tracing
+  int object_size;                                     // requested object size, rounded up to keep links aligned
+  int stride;                                          // object plus its free-list link
+  int objects_per_slab;
+  slab_ctor_t ctor;                                    // constructor for new objects, or NULL
+  void *free_list;                                     // free objects, linked through the word after each one
+  int num_slabs;                                       // slabs taken from the heap
+  int num_free;                                        // objects on the free list
+  int num_in_use;                                      // objects handed out and not yet freed
+} slab_cache_t;
+
+/*
+* Create a cache of objects of object_size bytes, running ctor (if not NULL) on each new object.
+* Returns NULL if we can't allocate it.
+*/
+slab_cache_t *create_slab_cache(char *name, int object_size, slab_ctor_t ctor);
+
+/*
+* Take a constructed object from the cache, growing it by a slab if it is empty.
+* Returns NULL if the kernel heap is exhausted.
+*/
+void *slab_alloc(slab_cache_t *cache);
+
+/*
+* Give an object (in its constructed state) back to the cache it came from. NULL is ignored.
+*/
+void slab_free(slab_cache_t *cache, void *object);
+
+#endif //CURRENT_CHUNGUS_SLAB_H
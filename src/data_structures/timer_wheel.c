@@ -0,0 +1,103 @@
+#include <ykernel.h>
+#include "timer_wheel.h"
+
+/*
+* Create an empty wheel at tick 0. Returns NULL if we can't allocate it.
+*/
+timer_wheel_t *create_timer_wheel() {
+  timer_wheel_t *wheel = malloc(sizeof(timer_wheel_t));
+  if (wheel == NULL) {
+    TracePrintf(1, "CREATE_TIMER_WHEEL: Unable to allocate memory for the timer wheel\n");
+    return NULL;
+  }
+  bzero(wheel, sizeof(timer_wheel_t));
+  return wheel;
+}
+
+/*
+* Set up a timer that isn't armed yet
+*/
+void init_timer(tick_timer_t *timer, timer_callback_t callback, void *arg) {
+  timer->expires = 0;
+  timer->armed = false;
+  timer->callback = callback;
+  timer->arg = arg;
+  timer->next = NULL;
+  timer->prev = NULL;
+}
+
+/*
+* Arm a timer to fire on the ticks-th clock tick from now. ticks must be at least 1, and the timer not armed.
+*/
+void add_timer(timer_wheel_t *wheel, tick_timer_t *timer, int ticks) {
+  if (ticks < 1) {
+    ticks = 1;
+  }
+  timer->expires = wheel->now + ticks;
+  timer->armed = true;
+
+  // stick it at the head of its slot
+  tick_timer_t **slot = &wheel->slots[timer->expires & TIMER_WHEEL_MASK];
+  timer->prev = NULL;
+  timer->next = *slot;
+  if (*slot != NULL) {
+    (*slot)->prev = timer;
+  }
+  *slot = timer;
+  wheel->num_armed++;
+}
+
+/*
+* Take a timer off the wheel without firing it. Returns false if it wasn't armed (e.g. it already fired).
+*/
+bool cancel_timer(timer_wheel_t *wheel, tick_timer_t *timer) {
+  if (!timer->armed) {
+    return false;
+  }
+  if (timer->prev != NULL) {
+    timer->prev->next = timer->next;
+  }
+  else {
+    wheel->slots[timer->expires & TIMER_WHEEL_MASK] = timer->next;
+  }
+  if (timer->next != NULL) {
+    timer->next->prev = timer->prev;
+  }
+  timer->next = NULL;
+  timer->prev = NULL;
+  timer->armed = false;
+  wheel->num_armed--;
+  return true;
+}
+
+/*
+* Advance the wheel by one tick, firing every timer that expires on it. Returns the number fired.
+*/
+int advance_timer_wheel(timer_wheel_t *wheel) {
+  wheel->now++;
+
+  // pull the expired timers out of the slot first, so that callbacks are free to add and cancel timers
+  tick_timer_t *expired = NULL;
+  tick_timer_t *timer = wheel->slots[wheel->now & TIMER_WHEEL_MASK];
+  while (timer != NULL) {
+    tick_timer_t *next = timer->next;
+    if (timer->expires == wheel->now) {
+      cancel_timer(wheel, timer);
+      timer->next = expired;
+      expired = timer;
+    }
+    timer = next;
+  }
+
+  int num_fired = 0;
+  while (expired != NULL) {
+    timer = expired;
+    expired = timer->next;
+    timer->next = NULL;
+    TracePrintf(5, "TIMER_WHEEL: Timer fired on tick %u\n", wheel->now);
+    timer->callback(timer);
+    num_fired++;
+  }
+  wheel->num_fired += num_fired;
+  return num_fired;
+}
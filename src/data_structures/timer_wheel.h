@@ -0,0 +1,63 @@
+#ifndef CURRENT_CHUNGUS_TIMER_WHEEL_H
+#define CURRENT_CHUNGUS_TIMER_WHEEL_H
+
+#include <ykernel.h>
+#include "stdbool.h"
+
+#define TIMER_WHEEL_SLOTS 64                           // must be a power of two
+#define TIMER_WHEEL_MASK (TIMER_WHEEL_SLOTS - 1)
+
+typedef struct tick_timer tick_timer_t;
+typedef void (*timer_callback_t)(tick_timer_t *timer);
+
+/*
+* A one-shot timer that runs its callback from the clock trap after some number of ticks.
+* Timers are embedded in whatever they time (e.g. the pcb for Delay), so arming one never allocates.
+*/
+struct tick_timer {
+  unsigned int expires;                                // the tick it fires on
+  bool armed;                                          // whether it is on the wheel
+  timer_callback_t callback;                           // run when it fires, after it is off the wheel
+  void *arg;                                           // for the callback, e.g. the pcb to wake up
+  struct tick_timer *next;                             // the next timer in its slot
+  struct tick_timer *prev;                             // the previous timer in its slot
+};
+
+/*
+* A hashed timing wheel. A timer expiring on tick t sits in slot t % TIMER_WHEEL_SLOTS, so each tick only
+* walks one slot: the timers due now, plus any due a multiple of TIMER_WHEEL_SLOTS ticks later.
+* Adding and cancelling a timer are O(1).
+*/
+typedef struct timer_wheel {
+  unsigned int now;                                    // clock ticks since boot
+  tick_timer_t *slots[TIMER_WHEEL_SLOTS];              // doubly linked lists of armed timers
+  int num_armed;                                       // timers on the wheel
+  int num_fired;                                       // timers that have fired since boot
+} timer_wheel_t;
+
+/*
+* Create an empty wheel at tick 0. Returns NULL if we can't allocate it.
+*/
+timer_wheel_t *create_timer_wheel();
+
+/*
+* Set up a timer that isn't armed yet
+*/
+void init_timer(tick_timer_t *timer, timer_callback_t callback, void *arg);
+
+/*
+* Arm a timer to fire on the ticks-th clock tick from now. ticks must be at least 1, and the timer not armed.
+*/
+void add_timer(timer_wheel_t *wheel, tick_timer_t *timer, int ticks);
+
+/*
+* Take a timer off the wheel without firing it. Returns false if it wasn't armed (e.g. it already fired).
+*/
+bool cancel_timer(timer_wheel_t *wheel, tick_timer_t *timer);
+
+/*
+* Advance the wheel by one tick, firing every timer that expires on it. Returns the number fired.
+*/
+int advance_timer_wheel(timer_wheel_t *wheel);
+
+#endif //CURRENT_CHUNGUS_TIMER_WHEEL_H
@@ -1,6 +1,7 @@
 #include <ykernel.h>
 #include "lock.h"
 #include "queue.h"
+#include "../process_management/scheduler.h"
 #include "stdbool.h"
 #include "tty.h"
 #include "cvar.h"
@@ -8,7 +9,7 @@
 extern pcb_t* running_process;
 extern pcb_t* idle_process;
 extern bool is_idle;
-extern queue_t* ready_queue;
+extern scheduler_t *scheduler_global;
 extern void *trap_handler[16];
 extern pte_t *region_0_page_table;
 extern tty_object_t *tty_objects[NUM_TERMINALS];
@@ -3,12 +3,13 @@
 #include "../data_structures/pcb.h"
 #include "../data_structures/queue.h"
 #include "../data_structures/frame_table.h"
+#include "../trap_handlers/trap_handlers.h"
 
 extern frame_table_struct_t *frame_table_global;
 extern pcb_t* running_process;
 extern pcb_t* idle_process;                                           // the special idle process; use when nothing is in ready queue
 extern bool is_idle;                                                  // if is_idle, we won't put the process back on the ready queue
-extern queue_t* ready_queue;
+extern scheduler_t *scheduler_global;
 extern void *trap_handler[16];
 extern pte_t *region_0_page_table;
 
@@ -90,10 +91,48 @@ void print_reg_1_page_table(pcb_t *process, int level, char *header) {
 // print the frame table (all frames)
 void print_frame_table(int level) {
     for (int i=0; i<frame_table_global->frame_table_size; i++) {
-        TracePrintf(level, "Frame %d: %d\n", i, frame_table_global->frame_table[i]);
+        frame_desc_t *frame = &frame_table_global->frames[i];
+        TracePrintf(level, "Frame %d: refcount %d, owner %d, pinned %d\n",
+                    i, frame->refcount, frame->owner_pid, frame->pinned);
     }
 }
 
+// print the buddy allocator's free blocks, fragmentation and counters
+void print_frame_stats(int level) {
+    frame_stats_t stats;
+    get_frame_stats(frame_table_global, &stats);
+    TracePrintf(level, "Frame stats: %d free frames, largest free order %d\n",
+                stats.num_free_frames, stats.largest_free_order);
+    TracePrintf(level, "Frame stats: %d allocs, %d failed, %d splits, %d merges, worst alloc %d splits\n",
+                stats.num_allocs, stats.num_alloc_failures, stats.num_splits, stats.num_merges,
+                stats.max_alloc_splits);
+    for (int order=0; order<=FRAME_MAX_ORDER; order++) {
+        TracePrintf(level, "Frame stats: order %d: %d free blocks, %d%% of free frames unusable\n",
+                    order, stats.free_blocks[order], stats.fragmentation[order]);
+    }
+}
+
+// print the clock trap counts and the average time spent in them
+void print_clock_stats(int level) {
+    long long idle_avg_ns = clock_stats.num_idle_ticks ? clock_stats.idle_ns / clock_stats.num_idle_ticks : 0;
+    long long busy_avg_ns = clock_stats.num_busy_ticks ? clock_stats.busy_ns / clock_stats.num_busy_ticks : 0;
+    TracePrintf(level, "Clock stats: %d ticks, tickless idle %s\n", clock_stats.num_ticks, tickless_idle ? "on" : "off");
+    TracePrintf(level, "Clock stats: %d idle ticks, avg %lld ns; %d busy ticks, avg %lld ns; %d untimed\n",
+                clock_stats.num_idle_ticks, idle_avg_ns, clock_stats.num_busy_ticks, busy_avg_ns,
+                clock_stats.num_ticks - clock_stats.num_idle_ticks - clock_stats.num_busy_ticks);
+}
+
+// print the scheduler's policy, ready processes and level changes
+void print_scheduler_stats(int level) {
+    TracePrintf(level, "Scheduler stats: %s, %d ready\n",
+                scheduler_global->policy == SCHED_MLFQ ? "mlfq" : "round robin", scheduler_global->num_ready);
+    for (int sched_level=0; sched_level<MLFQ_LEVELS; sched_level++) {
+        TracePrintf(level, "Scheduler stats: level %d: %d ready\n", sched_level, scheduler_global->levels[sched_level]->size);
+    }
+    TracePrintf(level, "Scheduler stats: %d demotions, %d promotions, %d boosts\n",
+                scheduler_global->num_demotions, scheduler_global->num_promotions, scheduler_global->num_boosts);
+}
+
 // print uctxt for a given process
 void print_uctxt(UserContext *uctxt, int level, char *header) {
     TracePrintf(level, "%s | pc: %x, sp: %x\n",
@@ -11,7 +11,7 @@ extern frame_table_struct_t *frame_table_global;
 extern pcb_t* running_process;
 extern pcb_t* idle_process;                                           // the special idle process; use when nothing is in ready queue
 extern bool is_idle;                                                  // if is_idle, we won't put the process back on the ready queue
-extern queue_t* ready_queue;
+extern scheduler_t *scheduler_global;
 extern void *trap_handler[16];
 extern pte_t *region_0_page_table;
 
@@ -30,6 +30,15 @@ void print_reg_1_page_table_contents(pcb_t *process, int level, char *header);
 // print the frame table (all frames)
 void print_frame_table(int level);
 
+// print the buddy allocator's free blocks, fragmentation and counters
+void print_frame_stats(int level);
+
+// print the clock trap counts and the average time spent in them
+void print_clock_stats(int level);
+
+// print the scheduler's policy, ready processes and level changes
+void print_scheduler_stats(int level);
+
 // print uctxt for a given process
 void print_uctxt(UserContext *uctxt, int level, char *header);
 
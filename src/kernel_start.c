@@ -35,7 +35,11 @@
 #include "data_structures/pipe.h"
 #include "data_structures/lock.h"
 #include "data_structures/tty.h"
+#include "data_structures/id_table.h"
+#include "data_structures/timer_wheel.h"
 #include "process_management/load_program.h"
+#include "memory/kstack_pool.h"
+#include "process_management/scheduler.h"
 #include "syscalls/io_syscalls.h"
 #include "debug_utils/debug.h"
 
@@ -61,32 +65,48 @@ int current_kernel_brk_page;
 frame_table_struct_t *frame_table_global;
 pte_t *region_0_page_table;
 char** cmd_args_global;
+kstack_pool_t *kstack_pool_global;
+int kstack_pool_high_water = KSTACK_POOL_DEFAULT_HIGH_WATER;    // set with the kstacks boot option
 
 // PROCESSES
 pcb_t* running_process;
 pcb_t* idle_process;                                           // the special idle process; use when nothing is in ready queue
 bool is_idle = false;                                          // if is_idle, we won't put the process back on the ready queue
-queue_t* ready_queue;
-pcb_t *delayed_processes = NULL;                               // a linked list of processes being delayed
+scheduler_t *scheduler_global;                                 // the ready processes
+int scheduler_policy = SCHED_ROUND_ROBIN;                      // set with the sched boot option
+timer_wheel_t *timer_wheel_global;                             // Delay (and any other timeouts) wait on this
+bool tickless_idle = true;                                     // skip idle-to-idle clock ticks; set with the tickless boot option
 
 // PIPES
-pipe_t* pipes = NULL;
+id_table_t *pipe_table;
 unsigned int min_possible_pipe_id = 0;
-unsigned int max_pipe_id = -1;
 unsigned int max_possible_pipe_id = 1000000;
 
 // LOCKS
-lock_t* locks = NULL;
+id_table_t *lock_table;
 unsigned int min_possible_lock_id = 2000000;
-unsigned int max_lock_id = 1999999;
 unsigned int max_possible_lock_id = 3000000;
 
 // CVARS
-cvar_t* cvars = NULL;
+id_table_t *cvar_table;
 unsigned int min_possible_cvar_id = 4000000;
-unsigned int max_cvar_id = 3999999;
 unsigned int max_possible_cvar_id = 5000000;
 
+// SEMAPHORES
+id_table_t *sem_table;
+unsigned int min_possible_sem_id = 6000000;
+unsigned int max_possible_sem_id = 7000000;
+
+// READER-WRITER LOCKS
+id_table_t *rwlock_table;
+unsigned int min_possible_rwlock_id = 8000000;
+unsigned int max_possible_rwlock_id = 9000000;
+
+// BARRIERS
+id_table_t *barrier_table;
+unsigned int min_possible_barrier_id = 10000000;
+unsigned int max_possible_barrier_id = 11000000;
+
 //TERMINALS
 tty_object_t *tty_objects[NUM_TERMINALS];
 char tty_buffer[TTY_BUFFER_SIZE];
@@ -107,7 +127,52 @@ char tty_buffer[TTY_BUFFER_SIZE];
 * For each of these addresses (lines), we bit-shift the address by PAGESHIFT to find out 
 * the page number it will correspond to in our page table. 
 */
+/*
+* Reads a non-negative number from a boot option value, or returns ERROR if it isn't one
+*/
+static int parse_boot_number(char *value) {
+  if (*value == '\0') {
+    return ERROR;
+  }
+  int number = 0;
+  for (; *value != '\0'; value++) {
+    if (*value < '0' || *value > '9') {
+      return ERROR;
+    }
+    number = number * 10 + (*value - '0');
+  }
+  return number;
+}
+
+/*
+* Boot options come before the init program on the command line, as name=value (e.g. kstacks=16).
+* We apply them and return the rest of cmd_args, which starts with the init program.
+*/
+static char **parse_boot_options(char *cmd_args[]) {
+  int i;
+  for (i = 0; cmd_args[i] != NULL && strchr(cmd_args[i], '=') != NULL; i++) {
+    char *option = cmd_args[i];
+    char *value = strchr(option, '=') + 1;
+    if (strncmp(option, "kstacks=", strlen("kstacks=")) == 0 && parse_boot_number(value) != ERROR) {
+      kstack_pool_high_water = parse_boot_number(value);
+    }
+    else if (strcmp(option, "sched=rr") == 0 || strcmp(option, "sched=mlfq") == 0) {
+      scheduler_policy = (strcmp(value, "mlfq") == 0) ? SCHED_MLFQ : SCHED_ROUND_ROBIN;
+    }
+    else if (strcmp(option, "tickless=0") == 0 || strcmp(option, "tickless=1") == 0) {
+      tickless_idle = (*value == '1');
+    }
+    else {
+      TracePrintf(0, "KernelStart: Ignoring bad boot option '%s'\n", option);
+      continue;
+    }
+    TracePrintf(1, "KernelStart: Boot option %s\n", option);
+  }
+  return &cmd_args[i];
+}
+
 void KernelStart(char *cmd_args[], unsigned int pmem_size, UserContext *uctxt) {
+  cmd_args = parse_boot_options(cmd_args);
   cmd_args_global = cmd_args;
 
   // full sizes
@@ -133,27 +198,40 @@ void KernelStart(char *cmd_args[], unsigned int pmem_size, UserContext *uctxt) {
   TracePrintf(1, "KernelBrk page initially set to %d\n", current_kernel_brk_page);
 
   // Frame table setup
-  // Create frame tracking bit vector and put it in the global along with its size
-  frame_table_global = malloc(sizeof(frame_table_global));
+  // Create the frame descriptor array (every frame starts out free) and put it in the global
+  frame_table_global = create_frame_table(total_pmem_pages);
   if (frame_table_global == NULL) {
-    TracePrintf(1, "KernelStart: Unable to allocate memory for frame table global. Halting.\n");
-    Halt();
-  }
-  char *frame_table = malloc(sizeof(char) * total_pmem_pages);
-  if (frame_table == NULL) {
     TracePrintf(1, "KernelStart: Unable to allocate memory for frame table. Halting.\n");
     Halt();
   }
-  frame_table_global->frame_table = frame_table;
-  frame_table_global->frame_table_size = total_pmem_pages;
 
   // Allocate global data structures
-  ready_queue = create_queue(); 
+  scheduler_global = create_scheduler(scheduler_policy);
+  if (scheduler_global == NULL) {
+    TracePrintf(1, "KernelStart: Unable to allocate memory for the scheduler. Halting.\n");
+    Halt();
+  }
   running_process = malloc(sizeof(pte_t *));
   if (running_process == NULL) {
     TracePrintf(1, "KernelStart: Unable to allocate memory for running process. Halting.\n");
     Halt();
   }
+  pipe_table = create_id_table(min_possible_pipe_id, max_possible_pipe_id);
+  lock_table = create_id_table(min_possible_lock_id, max_possible_lock_id);
+  cvar_table = create_id_table(min_possible_cvar_id, max_possible_cvar_id);
+  sem_table = create_id_table(min_possible_sem_id, max_possible_sem_id);
+  rwlock_table = create_id_table(min_possible_rwlock_id, max_possible_rwlock_id);
+  barrier_table = create_id_table(min_possible_barrier_id, max_possible_barrier_id);
+  if (pipe_table == NULL || lock_table == NULL || cvar_table == NULL || sem_table == NULL || rwlock_table == NULL
+      || barrier_table == NULL) {
+    TracePrintf(1, "KernelStart: Unable to allocate memory for the synchronization object tables. Halting.\n");
+    Halt();
+  }
+  timer_wheel_global = create_timer_wheel();
+  if (timer_wheel_global == NULL) {
+    TracePrintf(1, "KernelStart: Unable to allocate memory for the timer wheel. Halting.\n");
+    Halt();
+  }
 
   // helpers to walk through page table
   pte_t kernel_page;
@@ -181,14 +259,14 @@ void KernelStart(char *cmd_args[], unsigned int pmem_size, UserContext *uctxt) {
       else {
         kernel_page.valid = 1;
       }
-      frame_table[kernel_pageind] = 1;
+      reserve_frame(frame_table_global, kernel_pageind);
       kernel_page.prot = (PROT_READ | PROT_EXEC);
       kernel_page.pfn = kernel_pageind;
       region_0_page_table[kernel_pageind] = kernel_page;
     }
     // After text, we give data RW permissions
     else if (kernel_pageind >= (kernel_data_start_page-1) && kernel_pageind < current_kernel_brk_page) {
-      frame_table[kernel_pageind] = 1;
+      reserve_frame(frame_table_global, kernel_pageind);
       kernel_page.valid = 1;
       kernel_page.prot = (PROT_READ | PROT_WRITE);
       kernel_page.pfn = kernel_pageind;
@@ -196,26 +274,30 @@ void KernelStart(char *cmd_args[], unsigned int pmem_size, UserContext *uctxt) {
     }
     // Until the stack, we add invalid pages to give the kernel the illusion of the whole reg. 0 memory space
     else if (kernel_pageind >=  current_kernel_brk_page && kernel_pageind < stack_start_page) {
-      frame_table[kernel_pageind] = 1;
+      reserve_frame(frame_table_global, kernel_pageind);
       kernel_page.valid = 0;
       kernel_page.pfn = kernel_pageind;
       region_0_page_table[kernel_pageind] = kernel_page;
     }
     // then we mark the stack as valid 
     else if (kernel_pageind >= stack_start_page && kernel_pageind < stack_end_page) {
-      frame_table[kernel_pageind] = 1;
+      reserve_frame(frame_table_global, kernel_pageind);
       kernel_page.valid = 1;
        kernel_page.prot = (PROT_READ | PROT_WRITE);
       kernel_page.pfn = kernel_pageind;
       region_0_page_table[kernel_pageind] = kernel_page;
     }
-    // then we map the remainder of free physical frames
-    else {
-      frame_table[kernel_pageind] = 0;
-    }
+    // the remainder of physical frames were left free by create_frame_table
 
   }
 
+  // reserve kernel stacks for new processes now, while memory is plentiful
+  kstack_pool_global = create_kstack_pool(kstack_pool_high_water);
+  if (kstack_pool_global == NULL) {
+    TracePrintf(1, "KernelStart: Unable to allocate memory for the kernel stack pool. Halting.\n");
+    Halt();
+  }
+
   // update registers with region 0 page table
   WriteRegister(REG_PTBR0, (int) region_0_page_table);
   WriteRegister(REG_PTLR0, region_0_page_table_size);
@@ -268,7 +350,6 @@ void KernelStart(char *cmd_args[], unsigned int pmem_size, UserContext *uctxt) {
     TracePrintf(1, "Error: could not allocate memory for region 1 page table. Halting.\n");
     Halt();
   }
-  int first_possible_free_frame = 0;
   for (int ind=0; ind<page_table_reg_1_size; ind++) {
     // set everything under the stack as non-valid (since the text is in the kernel and
     // our loop shouldn't use any memory)
@@ -279,16 +360,11 @@ void KernelStart(char *cmd_args[], unsigned int pmem_size, UserContext *uctxt) {
     }
     // Here's the stack
     else {
-      int new_frame_num = get_free_frame(
-          frame_table_global->frame_table,
-          frame_table_global->frame_table_size,
-          first_possible_free_frame
-          );
-      if (new_frame_num == -1) {
+      int new_frame_num = get_free_frame(frame_table_global, FRAME_OWNER_KERNEL);
+      if (new_frame_num == MEMFULL) {
         TracePrintf(1, "Unable to get a free frame for the idle process user stack!\n");
         return;
       }
-      first_possible_free_frame = new_frame_num;
       idle_page.valid = 1;
       idle_page.prot = (PROT_READ | PROT_WRITE);
       idle_page.pfn = new_frame_num;
@@ -326,7 +402,7 @@ void KernelStart(char *cmd_args[], unsigned int pmem_size, UserContext *uctxt) {
   }
   int init_pid = helper_new_pid(init_pcb->region_1_page_table);
   init_pcb->pid = init_pid;
-  add_to_queue(ready_queue, init_pcb);
+  add_ready(scheduler_global, init_pcb);
 
   // update registers with the idle process's R1 page table
   WriteRegister(REG_PTBR1, (int) region_1_page_table);
@@ -409,26 +485,23 @@ int SetKernelBrk(void *addr) {
     TracePrintf(3, "SETKERNELBRK: VMem enabled. Setting kernel brk from %d to %d\n",
                 current_kernel_brk_page, addr_page);
 
-    int first_possible_free_frame = 0;
     if (addr_page > current_kernel_brk_page) {
       TracePrintf(3, "SETKERNELBRK: Will try to find memory to allocate more frames\n");
       // error out if we don't have enough memory
-      if (addr_page-current_kernel_brk_page > get_num_free_frames(frame_table_global->frame_table,
-                                                                   frame_table_global->frame_table_size)
-          ) {
+      if (addr_page-current_kernel_brk_page > get_num_free_frames(frame_table_global)) {
         TracePrintf(1, "SETKERNELBRK: SetKernelBrk did not find enough memory for the whole malloc to succeed\n");
         return ERROR;
       }
 
       TracePrintf(3, "SETKERNELBRK: SetKernelBrk found enough memory for malloc to succeed\n");
       while (addr_page > current_kernel_brk_page) {
-        int new_frame_num = get_free_frame(frame_table_global->frame_table,
-                                           frame_table_global->frame_table_size,
-                                           first_possible_free_frame);
-        if (new_frame_num == -1) {
+        int new_frame_num = get_free_frame(frame_table_global, FRAME_OWNER_KERNEL);
+        if (new_frame_num == MEMFULL) {
           TracePrintf(1, "SETKERNELBRK: SetKernelBrk was unable to allocate a new frame...\n");
           return ERROR;
         }
+        // kernel heap is never shared or reclaimed
+        pin_frame(frame_table_global, new_frame_num);
         region_0_page_table[current_kernel_brk_page].valid = 1;
         region_0_page_table[current_kernel_brk_page].prot = (PROT_READ | PROT_WRITE);
         region_0_page_table[current_kernel_brk_page].pfn = new_frame_num;
@@ -441,10 +514,13 @@ int SetKernelBrk(void *addr) {
       TracePrintf(3, "SETKERNELBRK: SetKernelBrk found that we don't need to allocate more frames\n");
       while (addr_page < current_kernel_brk_page) {
         TracePrintf(3, "SETKERNELBRK: Deleting a page from the page table...\n");
+        // the brk page is the first unmapped page, so step down to the last mapped one first
+        current_kernel_brk_page--;
         int discard_frame_number = region_0_page_table[current_kernel_brk_page].pfn;
-        frame_table_global->frame_table[discard_frame_number] = 0;
+        unpin_frame(frame_table_global, discard_frame_number);
+        release_frame(frame_table_global, discard_frame_number);
         region_0_page_table[current_kernel_brk_page].valid = 0;
-        current_kernel_brk_page--;
+        WriteRegister(REG_TLB_FLUSH, current_kernel_brk_page << PAGESHIFT);
       }
       return SUCCESS;
     }
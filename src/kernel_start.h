@@ -13,8 +13,12 @@
 #include "data_structures/pipe.h"
 #include "data_structures/cvar.h"
 #include "data_structures/tty.h"
+#include "data_structures/id_table.h"
+#include "data_structures/timer_wheel.h"
 #include "trap_handlers/trap_handlers.h"
 #include "process_management/load_program.h"
+#include "memory/kstack_pool.h"
+#include "process_management/scheduler.h"
 
 
 //=================== KERNEL GLOBALS ===================//
@@ -33,32 +37,46 @@ extern int current_kernel_brk_page;
 extern frame_table_struct_t *frame_table_global;
 extern pte_t *region_0_page_table;
 extern char** cmd_args_global;
+extern kstack_pool_t *kstack_pool_global;                             // recycled kernel stacks for new processes
 
 // PROCESSES
 extern pcb_t* running_process;
 extern pcb_t* idle_process;                                           // the special idle process; use when nothing is in ready queue
 extern bool is_idle;                                                  // if is_idle, we won't put the process back on the ready queue
-extern queue_t* ready_queue;
-extern pcb_t *delayed_processes;
+extern scheduler_t *scheduler_global;                                 // the ready processes
+extern timer_wheel_t *timer_wheel_global;
+extern bool tickless_idle;                                            // whether clock ticks with nothing to run return early
 
 // PIPES
-extern pipe_t* pipes;
+extern id_table_t *pipe_table;                                        // every pipe, indexed by its id
 extern unsigned int min_possible_pipe_id;                             // the minimum pipe id that may be allocated
-extern unsigned int max_pipe_id;                                      // the maximum pipe id currently being used
 extern unsigned int max_possible_pipe_id;                             // the maximum pipe id that may be allocated
 
 // LOCKS
-extern lock_t* locks;
+extern id_table_t *lock_table;                                        // every lock, indexed by its id
 extern unsigned int min_possible_lock_id;                             // the minimum lock id that may be allocated
-extern unsigned int max_lock_id;                                      // the maximum lock id currently being used
 extern unsigned int max_possible_lock_id;                             // the maximum lock id that may be allocated
 
 // CVAR
-extern cvar_t* cvars;
+extern id_table_t *cvar_table;                                        // every cvar, indexed by its id
 extern unsigned int min_possible_cvar_id;                             // the minimum cvar id that may be allocated
-extern unsigned int max_cvar_id;                                      // the maximum cvar id currently being used
 extern unsigned int max_possible_cvar_id;                             // the maximum cvar id that may be allocated
 
+// SEMAPHORES
+extern id_table_t *sem_table;                                         // every semaphore, indexed by its id
+extern unsigned int min_possible_sem_id;                              // the minimum semaphore id that may be allocated
+extern unsigned int max_possible_sem_id;                              // the maximum semaphore id that may be allocated
+
+// READER-WRITER LOCKS
+extern id_table_t *rwlock_table;                                      // every reader-writer lock, indexed by its id
+extern unsigned int min_possible_rwlock_id;                           // the minimum rwlock id that may be allocated
+extern unsigned int max_possible_rwlock_id;                           // the maximum rwlock id that may be allocated
+
+// BARRIERS
+extern id_table_t *barrier_table;                                     // every barrier, indexed by its id
+extern unsigned int min_possible_barrier_id;                          // the minimum barrier id that may be allocated
+extern unsigned int max_possible_barrier_id;                          // the maximum barrier id that may be allocated
+
 //TERMINALS
 extern tty_object_t *tty_objects[NUM_TERMINALS];                     // metadata tracking on all the terminals
 extern char tty_buffer[TTY_BUFFER_SIZE];                             // the buffer for all terminal input
@@ -3,14 +3,17 @@
 #include "data_structures/pcb.h"
 #include "data_structures/queue.h"
 #include "debug_utils/debug.h"
+#include "memory/demand_paging.h"
+#include "memory/kstack_pool.h"
 
 extern frame_table_struct_t *frame_table_global;
 extern pcb_t* running_process;
 extern pcb_t* idle_process;                                           // the special idle process; use when nothing is in ready queue
 extern bool is_idle;                                                  // if is_idle, we won't put the process back on the ready queue
-extern queue_t* ready_queue;
+extern scheduler_t *scheduler_global;
 extern void *trap_handler[16];
 extern pte_t *region_0_page_table;
+extern kstack_pool_t *kstack_pool_global;
 
 int switch_between_processes_delete_old(pcb_t *current_process, pcb_t *next_process);
 
@@ -21,6 +24,12 @@ int switch_between_processes_delete_old(pcb_t *current_process, pcb_t *next_proc
 int clone_process(pcb_t *new_pcb) {
   pcb_t* parent = running_process;
 
+  // callers that have to undo work on failure take the stack up front; otherwise we take it here
+  if (!new_pcb->kernel_stack[0].valid && take_kernel_stack(kstack_pool_global, new_pcb) == ERROR) {
+    TracePrintf(1, "Out of kernel stacks; unable to clone process %d\n", new_pcb->pid);
+    return ERROR;
+  }
+
   print_reg_1_page_table(new_pcb, 5, "PRE SWITCH CLONE UTILITY");
   print_reg_1_page_table_contents(new_pcb, 5, "PRE SWITCH CLONE UTILITY");
   int rc = KernelContextSwitch(&KCCopy, (void *)new_pcb, NULL);
@@ -60,34 +69,34 @@ int clone_process(pcb_t *new_pcb) {
  *  If code==-1
  *    deletes the old process
  *  If code==0
- *    adds old process back into ready queue
+ *    adds old process back into ready queue, or leaves it running if nothing else is ready
  *  Otherwise
  *    the old process is blocked for some reason
  */
 int install_next_from_queue(pcb_t* current_process, int code) {
   pcb_t* next_process;
+  // a runnable process with nobody waiting behind it just keeps going, rather than being swapped for idle and back
+  if (!has_ready(scheduler_global) && code == 0 && !is_idle) {
+    TracePrintf(1, "INSTALL_NEXT: Queue is empty, process %d keeps running\n", current_process->pid);
+    return SUCCESS;
+  }
+
   // check if there is another process in the ready queue
-  if (is_empty(ready_queue)) {
+  if (!has_ready(scheduler_global)) {
     TracePrintf(1, "INSTALL_NEXT: Queue is empty, the next process is idle\n");
-    // if not, swap in the idle pcb and put the old pcb in the ready queue
+    // if not, swap in the idle pcb
     next_process = idle_process;
-    // we add the valid process back into the ready queue
-    if (code == 0 && !is_idle) {
-      add_to_queue(ready_queue, running_process);
-    }
     is_idle = true;
   }
   else {
     TracePrintf(1, "INSTALL_NEXT: Getting next item from the queue\n");
-    // if so, swap in the next process in the ready queue
-    next_process = remove_from_queue(ready_queue);
-    if (is_idle) {
-      is_idle = false;
-    }
-    // we add the valid process back into the ready queue
-    else if (code == 0) {
-      add_to_queue(ready_queue, running_process);
+    // we add the valid process back into the ready queue before choosing, so it competes with the rest
+    if (!is_idle && code == 0) {
+      requeue_preempted(scheduler_global, running_process);
     }
+    // swap in the next process the scheduler picks
+    next_process = remove_next_ready(scheduler_global);
+    is_idle = false;
   }
 
   TracePrintf(3, "INSTALL_NEXT: ABOUT TO SWAP PROCESSES\n");
@@ -108,10 +117,48 @@ int install_next_from_queue(pcb_t* current_process, int code) {
   }
 }
 
+/*
+ * Timer callback for timed waits: if the process is still on the queue it blocked on, nobody woke it in time, so
+ * take it off and make it ready. If it isn't, it was woken first and is already on its way.
+ */
+static void time_out_wait(tick_timer_t *timer) {
+  pcb_t *process = (pcb_t *) timer->arg;
+  if (remove_pcb_from_queue(process->timed_wait_queue, process)) {
+    TracePrintf(1, "TIMED_WAIT: Process %d timed out\n", process->pid);
+    process->wait_timed_out = true;
+    add_ready(scheduler_global, process);
+  }
+}
+
+/*
+ * Blocks the running process on queue until it is taken off, or until its delay_timer fires
+ */
+bool block_with_timeout(queue_t *queue, int ticks) {
+  pcb_t *process = running_process;
+  process->wait_timed_out = false;
+  process->timed_wait_queue = queue;
+  init_timer(&process->delay_timer, &time_out_wait, process);
+  add_timer(timer_wheel_global, &process->delay_timer, ticks);
+
+  add_to_queue(queue, process);
+  install_next_from_queue(process, 1);
+
+  // we may have been woken before the timer fired
+  cancel_timer(timer_wheel_global, &process->delay_timer);
+  process->timed_wait_queue = NULL;
+  return process->wait_timed_out;
+}
+
 /*
 * This is the highest level function for switching between different processes.
 */
 int switch_between_processes(pcb_t *current_process, pcb_t *next_process) {
+  // switching to ourselves (e.g. idle to idle) needs no new page table, TLB flush or kernel context
+  if (current_process == next_process) {
+    TracePrintf(3, "SWITCH: Process %d is already running\n", next_process->pid);
+    return 0;
+  }
+
   // sets the R1 PT
   WriteRegister(REG_PTBR1, (int) next_process->region_1_page_table);
   // Wipes the TLB for the entire process
@@ -138,14 +185,7 @@ int destroy_process_no_switch(pcb_t* process) {
   delete_r1_page_table(process, -1);
 
   TracePrintf(5, "=====Freeing KernelStack=====\n");
-  int num_stack_pages = KERNEL_STACK_MAXSIZE >> PAGESHIFT;
-  for (int i=0; i<num_stack_pages; i++) {
-    // free the existing R0 kernel page tables
-    if (process->kernel_stack[i].valid) {
-      process->kernel_stack[i].valid = false;
-      frame_table_global->frame_table[process->kernel_stack[i].pfn] = 0;
-    }
-  }
+  return_kernel_stack(kstack_pool_global, process->kernel_stack);
 
   return SUCCESS;
 }
@@ -172,22 +212,47 @@ int switch_between_processes_delete_old(pcb_t *current_process, pcb_t *next_proc
   return 0;
 }
 
+/*
+ * Hands a VFork child's borrowed region 1 back to its parent, and wakes the parent up
+ */
+void return_borrowed_address_space(pcb_t *child) {
+  pcb_t *parent = child->vfork_parent;
+  if (parent == NULL) {
+    return;
+  }
+  TracePrintf(1, "VFORK: Child %d is giving the address space back to %d\n", child->pid, parent->pid);
+  // the table, flags and image were never the child's, so there is nothing of them to free
+  use_own_region_1(child);
+  child->image = NULL;
+  child->vfork_parent = NULL;
+
+  parent->waitingForVforkChild = false;
+  add_ready(scheduler_global, parent);
+}
+
 /*
  * Clears the page table up to the upto index
  */
 int delete_r1_page_table(pcb_t *process, int upto_index) {
+  // already wiped out
+  if (process->region_1_page_table == NULL) {
+    return SUCCESS;
+  }
   // wipe out the page table for the process
   int region_1_page_table_size = UP_TO_PAGE(VMEM_1_SIZE) >> PAGESHIFT;
   for (int i = 0; (i < region_1_page_table_size && (upto_index == -1 || i <= upto_index)); i++) {
     if (process->region_1_page_table[i].valid) {
       TracePrintf(5, "DELETE R1 PAGE TABLE: Removing %d from frame table\n", process->region_1_page_table[i].pfn);
-      frame_table_global->frame_table[process->region_1_page_table[i].pfn] = 0;
+      // frames shared copy-on-write stay allocated until their last sharer lets go
+      release_frame(frame_table_global, process->region_1_page_table[i].pfn);
       process->region_1_page_table[i].valid = false;
     }
+    process->page_flags[i] = 0;
   }
+  release_exec_image(process->image);
+  process->image = NULL;
 
-  TracePrintf(5, "DELETE R1 PAGE TABLE: Zeroed R1 page table\n");
-  free(process->region_1_page_table);
+  // the table itself is part of the pcb's slab object, and goes when the pcb does
   TracePrintf(5, "DELETE R1 PAGE TABLE: Wiped out R1 page table\n");
   process->region_1_page_table = NULL;
 }
@@ -204,6 +269,12 @@ delete_process(pcb_t* process, int status_code, bool do_process_switch)
 {
   TracePrintf(1, "DELETE PROCESS: Attempting to delete process %d with exit code %d\n", (process->pid), status_code);
 
+  // a VFork child gives its parent's address space back before we free anything
+  return_borrowed_address_space(process);
+
+  // a process killed in Delay must not be woken up later
+  cancel_timer(timer_wheel_global, &process->delay_timer);
+
   // check to see if the parent is dead; if so, completely delete the PCB and switch to the next possible process
   if (process->parent == NULL || process->parent->hasExited == true) {
     if (do_process_switch) {
@@ -213,7 +284,7 @@ delete_process(pcb_t* process, int status_code, bool do_process_switch)
     }
     else {
       destroy_process_no_switch(process);
-      free(process);
+      free_pcb(process);
     }
   }
 
@@ -242,7 +313,7 @@ delete_process(pcb_t* process, int status_code, bool do_process_switch)
       }
       else {
         destroy_process_no_switch(process);
-        free(process);
+        free_pcb(process);
       }
     }
     else {
@@ -273,19 +344,14 @@ KernelContext *KCSwitchDelete( KernelContext *kc_in, void *curr_pcb_p, void *nex
 
   TracePrintf(5, "=====Freeing KernelStack=====\n");
   int num_stack_pages = KERNEL_STACK_MAXSIZE >> PAGESHIFT;
+  // the stack we are leaving goes back to the pool for the next new process
+  for (int i=0; i<num_stack_pages; i++) {
+    int stack_page_ind = (KERNEL_STACK_BASE >> PAGESHIFT) + i;
+    curr_pcb->kernel_stack[i] = region_0_page_table[stack_page_ind];
+  }
+  return_kernel_stack(kstack_pool_global, curr_pcb->kernel_stack);
   for (int i=0; i<num_stack_pages; i++) {
     int stack_page_ind = (KERNEL_STACK_BASE >> PAGESHIFT) + i;
-    // free the existing R0 kernel page tables
-    if (region_0_page_table[stack_page_ind].valid) {
-      region_0_page_table[stack_page_ind].valid = false;
-      frame_table_global->frame_table[region_0_page_table[stack_page_ind].pfn] = 0;
-      TracePrintf(5, "Deleting page in PCB: Addr: %x to %x, Valid: %d, Pfn: %d\n",
-                  VMEM_0_BASE + (stack_page_ind << PAGESHIFT),
-                  VMEM_0_BASE + ((stack_page_ind+1) << PAGESHIFT)-1,
-                  region_0_page_table[stack_page_ind].valid,
-                  region_0_page_table[stack_page_ind].pfn
-      );
-    }
 
     // change the Region 0 kernel stack mappings to those for the new PCB
     region_0_page_table[stack_page_ind] = next_pcb->kernel_stack[i];
@@ -385,7 +451,7 @@ KernelContext *KCCopy( KernelContext *kc_in, void *new_pcb_p,void *not_used) {
   TracePrintf(5, "=====Region 0 Page Table Before Clone=====\n");
   print_reg_0_page_table(5, "");
 
-  //copy current kernel stack into new kstack frames
+  //copy current kernel stack into the new pcb's kstack frames, which clone_process took from the pool
   int num_stack_pages = KERNEL_STACK_MAXSIZE >> PAGESHIFT;
   for (int i=0; i<num_stack_pages; i++) {
     // bufpage should be just below the stack (-1, then -2)
@@ -394,11 +460,13 @@ KernelContext *KCCopy( KernelContext *kc_in, void *new_pcb_p,void *not_used) {
 
     // get the index of the stack page to copy
     int stack_page_ind = (KERNEL_STACK_BASE >> PAGESHIFT) + i;
-    int new_frame = get_free_frame(frame_table_global->frame_table, frame_table_global->frame_table_size, 0);
+    int new_frame = new_pcb->kernel_stack[i].pfn;
     // use the page below the stack as a buffer to write stack pages into frames
     bufpage->valid = 1;
     bufpage->prot = (PROT_READ | PROT_WRITE);
     bufpage->pfn = new_frame;
+    // the buffer page pointed at some other frame last time around
+    WriteRegister(REG_TLB_FLUSH, bufpage_index << PAGESHIFT);
 
     //copy stack page into the new frame
     TracePrintf(5, "copying %d bytes from [%p, %p] to %p\n",
@@ -409,13 +477,6 @@ KernelContext *KCCopy( KernelContext *kc_in, void *new_pcb_p,void *not_used) {
 
     memcpy((void *)(bufpage_index << PAGESHIFT), (void *)(stack_page_ind << PAGESHIFT), PAGESIZE);
 
-    //now copy that page (and associated frame) into the new pcb
-    pte_t page;
-    page.valid = 1;
-    page.prot = bufpage->prot;
-    page.pfn = bufpage->pfn;
-    new_pcb->kernel_stack[i] = page;
-
     // invalidate the bufpage, so it doesn't stick around on the stack
     bufpage->valid = 0;
   }
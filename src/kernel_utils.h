@@ -3,8 +3,9 @@
 #include <ykernel.h>
 #include "data_structures/pcb.h"
 #include "data_structures/queue.h"
+#include "process_management/scheduler.h"
 
-extern queue_t* ready_queue;
+extern scheduler_t *scheduler_global;
 
 /*
 * Top level helper to clone processes. Handles error handling, KernelContextSwitch call.
@@ -16,12 +17,20 @@ int clone_process();
  *  If code==-1
  *    deletes the old process
  *  If code==0
- *    adds old process back into ready queue
+ *    adds old process back into ready queue, or leaves it running if nothing else is ready
  *  Otherwise
  *    the old process is blocked for some reason
  */
 int install_next_from_queue(pcb_t* current_process, int code);
 
+/*
+ * Blocks the running process on queue until someone takes it off (e.g. release handing it a lock), or for at most
+ * ticks clock ticks (at least 1), after which the clock trap takes it off the queue and makes it ready.
+ * Anyone else who wakes the process without taking it off the queue normally must cancel its delay_timer first.
+ * returns true if the wait timed out
+ */
+bool block_with_timeout(queue_t *queue, int ticks);
+
 /*
 * Top level helper to switch processes. Handles KernelContextSwitch call.
 */
@@ -32,6 +41,17 @@ int switch_between_processes(pcb_t *current_process, pcb_t *next_process);
  */
 int delete_r1_page_table(pcb_t *process, int upto_index);
 
+/*
+ * Frees the pid, region 1 page table and kernel stack of a process that isn't the running one
+ */
+int destroy_process_no_switch(pcb_t* process);
+
+/*
+ * Ends a VFork child's use of its parent's address space. The child is left with its own empty region 1 and
+ * no exec image, and the parent is put back on the ready queue.
+ */
+void return_borrowed_address_space(pcb_t *child);
+
 /*
  * Deletes the process if no parent
  * If there is parent, triggers it
@@ -1,6 +1,8 @@
 #include <ykernel.h>
 #include <hardware.h>
 #include "../kernel_start.h"
+#include "cow.h"
+#include "demand_paging.h"
 
 /*
  *
@@ -151,11 +153,22 @@ int check_memory(void* mem_loc, unsigned int mem_size,
 
   // check all the page table entries between start and end page to see if they're valid
   for (int i = start_page_idx; i <= end_page_idx; i++) {
+    // the kernel is about to touch a page we haven't loaded from the executable yet, so load it now
+    if (is_file_backed_page(running_process, i) && page_in(running_process, i) == ERROR) {
+      TracePrintf(1, "CHECK_MEMORY: Unable to load R1 page from the executable!\n");
+      return ERROR;
+    }
     if (!running_process->region_1_page_table[i].valid) {
       TracePrintf(1, "CHECK_MEMORY: Found invalid R1 page!\n");
       return ERROR;
     }
 
+    // the kernel is about to write here on the user's behalf, so give the process its own copy of a COW page now
+    if (write_required && is_cow_page(running_process, i) && break_cow_page(running_process, i) == ERROR) {
+      TracePrintf(1, "CHECK_MEMORY: Unable to copy a copy-on-write page for writing!\n");
+      return ERROR;
+    }
+
     if (check_page(running_process->region_1_page_table[i].prot, read_required, write_required, exec_required) == ERROR) {
       TracePrintf(1, "CHECK_MEMORY: Found R1 page with the wrong permissions!\n");
       return ERROR;
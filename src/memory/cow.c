@@ -0,0 +1,145 @@
+#include <ykernel.h>
+#include "cow.h"
+#include "../kernel_start.h"
+#include "../data_structures/pcb.h"
+#include "../data_structures/frame_table.h"
+#include "demand_paging.h"
+
+extern frame_table_struct_t *frame_table_global;
+extern pte_t *region_0_page_table;
+
+/*
+ * Maps frame pfn at the buffer page just below the kernel stack and returns its address. KCCopy borrows the same
+ * page, but never while we hold it, since we map and unmap it without blocking in between.
+ */
+static void *map_buffer_page(int pfn) {
+  int bufpage_index = (KERNEL_STACK_BASE >> PAGESHIFT) - 1;
+  pte_t *bufpage = &region_0_page_table[bufpage_index];
+  bufpage->valid = 1;
+  bufpage->prot = (PROT_READ | PROT_WRITE);
+  bufpage->pfn = pfn;
+  return (void *)(VMEM_0_BASE + (bufpage_index << PAGESHIFT));
+}
+
+/*
+ * Unmaps the buffer page and flushes it, so the next user doesn't go through a stale mapping
+ */
+static void unmap_buffer_page() {
+  int bufpage_index = (KERNEL_STACK_BASE >> PAGESHIFT) - 1;
+  region_0_page_table[bufpage_index].valid = 0;
+  WriteRegister(REG_TLB_FLUSH, VMEM_0_BASE + (bufpage_index << PAGESHIFT));
+}
+
+/*
+ * Returns true if page (a region 1 page index) of this process is shared copy-on-write
+ */
+bool is_cow_page(pcb_t *process, int page) {
+  int region_1_page_table_size = UP_TO_PAGE(VMEM_1_SIZE) >> PAGESHIFT;
+  if (page < 0 || page >= region_1_page_table_size) {
+    return false;
+  }
+  return process->region_1_page_table[page].valid && (process->page_flags[page] & PAGE_FLAG_COW);
+}
+
+/*
+ * Shares the page at index page of parent into child. Writable pages lose PROT_WRITE in both processes and get
+ * tagged COW; pages that were never writable, and pages the parent asked to share, are simply shared.
+ */
+void share_page_cow(pcb_t *parent, pcb_t *child, int page) {
+  pte_t *parent_page = &parent->region_1_page_table[page];
+
+  if ((parent_page->prot & PROT_WRITE) && !(parent->page_flags[page] & PAGE_FLAG_SHARED)) {
+    parent_page->prot &= ~PROT_WRITE;
+    parent->page_flags[page] |= PAGE_FLAG_COW;
+  }
+
+  // keep the existing (now read-only) permissions and point at the same frame
+  child->region_1_page_table[page] = *parent_page;
+  child->page_flags[page] = parent->page_flags[page];
+  share_frame(frame_table_global, parent_page->pfn);
+}
+
+/*
+ * Resolves a write to a copy-on-write page of the running process.
+ * The page must be mapped in the current region 1 page table, since we copy out of its virtual address.
+ */
+int break_cow_page(pcb_t *process, int page) {
+  pte_t *user_page = &process->region_1_page_table[page];
+  void *user_addr = (void *)(VMEM_1_BASE + (page << PAGESHIFT));
+
+  // the last sharer keeps the frame; it only needs its write permission back
+  if (!frame_is_shared(frame_table_global, user_page->pfn)) {
+    TracePrintf(5, "COW: Page %d of pid %d is no longer shared; restoring write access\n", page, process->pid);
+    user_page->prot |= PROT_WRITE;
+    process->page_flags[page] &= ~PAGE_FLAG_COW;
+    WriteRegister(REG_TLB_FLUSH, (int) user_addr);
+    return SUCCESS;
+  }
+
+  int new_frame = get_free_frame_or_evict(process->pid);
+  if (new_frame == MEMFULL) {
+    TracePrintf(1, "COW: Ran out of free frames to copy page %d of pid %d!\n", page, process->pid);
+    return ERROR;
+  }
+
+  // write the copy into the new frame through the buffer page
+  TracePrintf(5, "COW: Copying page %d of pid %d from frame %d to frame %d\n",
+              page, process->pid, user_page->pfn, new_frame);
+  memcpy(map_buffer_page(new_frame), user_addr, PAGESIZE);
+  unmap_buffer_page();
+
+  // drop our reference to the shared frame and map the private copy
+  release_frame(frame_table_global, user_page->pfn);
+  user_page->pfn = new_frame;
+  user_page->prot |= PROT_WRITE;
+  process->page_flags[page] &= ~PAGE_FLAG_COW;
+  WriteRegister(REG_TLB_FLUSH, (int) user_addr);
+
+  return SUCCESS;
+}
+
+/*
+ * Write-protects a page of the running process the same way fork does for the parent, and takes a new reference on
+ * its frame for the caller. The frame's contents can't change under the caller from here on: a write by the process
+ * breaks the COW and lands in a copy.
+ */
+int share_frame_cow(pcb_t *process, int page) {
+  pte_t *user_page = &process->region_1_page_table[page];
+
+  if (user_page->prot & PROT_WRITE) {
+    user_page->prot &= ~PROT_WRITE;
+    process->page_flags[page] |= PAGE_FLAG_COW;
+    WriteRegister(REG_TLB_FLUSH, VMEM_1_BASE + (page << PAGESHIFT));
+  }
+  share_frame(frame_table_global, user_page->pfn);
+  return user_page->pfn;
+}
+
+/*
+ * Points a page of the running process at pfn instead of its own frame, which is released. The page stays
+ * writable only if nobody else maps pfn; otherwise it is read-only and tagged COW, like a page shared by fork.
+ */
+void map_frame_cow(pcb_t *process, int page, int pfn) {
+  pte_t *user_page = &process->region_1_page_table[page];
+
+  release_frame(frame_table_global, user_page->pfn);
+  user_page->pfn = pfn;
+  if (frame_is_shared(frame_table_global, pfn)) {
+    user_page->prot &= ~PROT_WRITE;
+    process->page_flags[page] |= PAGE_FLAG_COW;
+  }
+  else {
+    user_page->prot |= PROT_WRITE;
+    process->page_flags[page] &= ~PAGE_FLAG_COW;
+  }
+  WriteRegister(REG_TLB_FLUSH, VMEM_1_BASE + (page << PAGESHIFT));
+}
+
+/*
+ * Copies len bytes starting offset bytes into frame pfn out to dest, through the buffer page
+ */
+void copy_from_frame(int pfn, int offset, void *dest, int len) {
+  char *frame_addr = map_buffer_page(pfn);
+  memcpy(dest, frame_addr + offset, len);
+  unmap_buffer_page();
+}
@@ -0,0 +1,54 @@
+#ifndef CURRENT_CHUNGUS_COW_H
+#define CURRENT_CHUNGUS_COW_H
+
+#include <ykernel.h>
+#include "../data_structures/pcb.h"
+
+/*
+ * Copy-on-write support for fork.
+ *
+ * Fork shares every writable region 1 frame between parent and child, maps it read-only in both
+ * and tags the page with PAGE_FLAG_COW. The first write to such a page traps into
+ * handle_trap_memory, which calls break_cow_page to give the writer its own copy.
+ */
+
+/*
+ * Returns true if page (a region 1 page index) of this process is shared copy-on-write
+ */
+bool is_cow_page(pcb_t *process, int page);
+
+/*
+ * Shares the page at index page of parent into child copy-on-write: both processes end up mapping the same frame
+ * read-only, and the frame's share count goes up by one. Read-only pages (e.g. text) are shared without the COW tag,
+ * and PAGE_FLAG_SHARED pages stay writable in both, so that the processes see each other's writes.
+ * The caller is responsible for flushing the parent's region 1 TLB entries afterwards.
+ */
+void share_page_cow(pcb_t *parent, pcb_t *child, int page);
+
+/*
+ * Resolves a write to a copy-on-write page of the RUNNING process. If no one else maps the frame anymore we simply
+ * make the page writable again; otherwise we copy it into a fresh frame through the buffer page below the kernel stack.
+ *
+ * Returns SUCCESS, or ERROR if we are out of frames.
+ */
+int break_cow_page(pcb_t *process, int page);
+
+/*
+ * Write-protects page (a region 1 page index) of the RUNNING process copy-on-write and returns its frame with a new
+ * reference on it for the caller, e.g. a pipe that a write flips the page into. PROT_WRITE pages get the COW tag;
+ * the caller should skip PAGE_FLAG_SHARED pages, whose frame other processes can still write.
+ */
+int share_frame_cow(pcb_t *process, int page);
+
+/*
+ * Maps frame pfn at page (a region 1 page index) of the RUNNING process in place of the page's own frame, taking over
+ * the caller's reference on pfn. The page is tagged COW if pfn is still mapped somewhere else.
+ */
+void map_frame_cow(pcb_t *process, int page, int pfn);
+
+/*
+ * Copies len bytes, starting offset bytes into frame pfn, to dest in the current address space
+ */
+void copy_from_frame(int pfn, int offset, void *dest, int len);
+
+#endif //CURRENT_CHUNGUS_COW_H
@@ -0,0 +1,271 @@
+#include <unistd.h>
+#include <sys/stat.h>
+#include <ykernel.h>
+#include <load_info.h>
+#include "demand_paging.h"
+#include "../data_structures/pcb.h"
+#include "../data_structures/frame_table.h"
+
+extern frame_table_struct_t *frame_table_global;
+
+exec_image_t *exec_image_cache = NULL;                // every cached image, newest first
+
+/*
+ * Frees an image no process is using: drops the cache's references to its text frames, closes the
+ * executable and unlinks it from the cache
+ */
+static void evict_exec_image(exec_image_t *image) {
+  TracePrintf(5, "DEMAND_PAGING: Evicting exec image on fd %d\n", image->fd);
+  exec_image_t **link = &exec_image_cache;
+  while (*link != image) {
+    link = &(*link)->next;
+  }
+  *link = image->next;
+
+  for (int i=0; i<image->t_npg; i++) {
+    if (image->text_frames[i] != FRAME_NONE) {
+      release_frame(frame_table_global, image->text_frames[i]);
+    }
+  }
+  close(image->fd);
+  free(image->text_frames);
+  free(image);
+}
+
+/*
+ * Returns a new reference to the image for the executable open on fd, reusing a cached image of the same file
+ */
+exec_image_t *open_exec_image(int fd, struct load_info *li) {
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) < 0) {
+    TracePrintf(1, "DEMAND_PAGING: Unable to stat the executable on fd %d\n", fd);
+    return NULL;
+  }
+  for (exec_image_t *image = exec_image_cache; image != NULL; image = image->next) {
+    if (image->dev == file_stat.st_dev && image->ino == file_stat.st_ino && image->mtime == file_stat.st_mtime) {
+      TracePrintf(5, "DEMAND_PAGING: Found a cached exec image for this executable\n");
+      close(fd);
+      return retain_exec_image(image);
+    }
+  }
+
+  exec_image_t *image = malloc(sizeof(exec_image_t));
+  if (image == NULL) {
+    TracePrintf(1, "DEMAND_PAGING: Unable to allocate memory for an exec image\n");
+    return NULL;
+  }
+  image->text_frames = malloc(sizeof(int) * li->t_npg);
+  if (image->text_frames == NULL) {
+    TracePrintf(1, "DEMAND_PAGING: Unable to allocate memory for an exec image's text frames\n");
+    free(image);
+    return NULL;
+  }
+  for (int i=0; i<li->t_npg; i++) {
+    image->text_frames[i] = FRAME_NONE;
+  }
+  image->fd = fd;
+  image->refcount = 1;
+  image->dev = file_stat.st_dev;
+  image->ino = file_stat.st_ino;
+  image->mtime = file_stat.st_mtime;
+  image->t_vaddr = li->t_vaddr;
+  image->t_faddr = li->t_faddr;
+  image->t_npg = li->t_npg;
+  image->id_vaddr = li->id_vaddr;
+  image->id_faddr = li->id_faddr;
+  image->id_npg = li->id_npg;
+  image->id_end = li->id_end;
+  image->ud_end = li->ud_end;
+  image->next = exec_image_cache;
+  exec_image_cache = image;
+  return image;
+}
+
+/*
+ * Takes another reference to an image
+ */
+exec_image_t *retain_exec_image(exec_image_t *image) {
+  if (image != NULL) {
+    image->refcount++;
+  }
+  return image;
+}
+
+/*
+ * Drops a reference to an image. Once there are too many unused images, the oldest unused one is evicted.
+ */
+void release_exec_image(exec_image_t *image) {
+  if (image == NULL) {
+    return;
+  }
+  image->refcount--;
+  if (image->refcount > 0) {
+    return;
+  }
+
+  // the cache is newest first, so the last unused image we walk past is the oldest
+  int num_unused = 0;
+  exec_image_t *oldest_unused = NULL;
+  for (exec_image_t *cached = exec_image_cache; cached != NULL; cached = cached->next) {
+    if (cached->refcount == 0) {
+      num_unused++;
+      oldest_unused = cached;
+    }
+  }
+  if (num_unused > EXEC_IMAGE_CACHE_IDLE) {
+    evict_exec_image(oldest_unused);
+  }
+}
+
+/*
+ * Returns the frame already holding a text page of this image with a new reference on it, or FRAME_NONE
+ */
+int share_cached_text_frame(exec_image_t *image, int text_page) {
+  if (image == NULL || text_page < 0 || text_page >= image->t_npg || image->text_frames[text_page] == FRAME_NONE) {
+    return FRAME_NONE;
+  }
+  share_frame(frame_table_global, image->text_frames[text_page]);
+  return image->text_frames[text_page];
+}
+
+/*
+ * Evicts every cached image no process is using
+ */
+int evict_unused_exec_images() {
+  int num_evicted = 0;
+  exec_image_t *image = exec_image_cache;
+  while (image != NULL) {
+    exec_image_t *next = image->next;
+    if (image->refcount == 0) {
+      evict_exec_image(image);
+      num_evicted++;
+    }
+    image = next;
+  }
+  return num_evicted;
+}
+
+/*
+ * Takes a frame for owner_pid. Cached text that no process is running may be holding the memory we need, so if
+ * the frame table is full we evict the unused images and try once more.
+ */
+int get_free_frame_or_evict(int owner_pid) {
+  int frame = get_free_frame(frame_table_global, owner_pid);
+  if (frame == MEMFULL && evict_unused_exec_images() > 0) {
+    frame = get_free_frame(frame_table_global, owner_pid);
+  }
+  return frame;
+}
+
+/*
+ * Takes num_frames frames for owner_pid, all or nothing, evicting unused images and retrying like
+ * get_free_frame_or_evict
+ */
+int get_free_frames_or_evict(int num_frames, int owner_pid, int *pfns) {
+  int rc = get_free_frames(frame_table_global, num_frames, owner_pid, pfns);
+  if (rc == MEMFULL && evict_unused_exec_images() > 0) {
+    rc = get_free_frames(frame_table_global, num_frames, owner_pid, pfns);
+  }
+  return rc;
+}
+
+/*
+ * Returns true if page (a region 1 page index) of this process hasn't been loaded from its executable yet
+ */
+bool is_file_backed_page(pcb_t *process, int page) {
+  int region_1_page_table_size = UP_TO_PAGE(VMEM_1_SIZE) >> PAGESHIFT;
+  if (page < 0 || page >= region_1_page_table_size || process->image == NULL) {
+    return false;
+  }
+  return !process->region_1_page_table[page].valid && (process->page_flags[page] & PAGE_FLAG_FILE);
+}
+
+/*
+ * Reads the part of a file segment [seg_vaddr, seg_vaddr + seg_len) that overlaps the page at page_addr
+ * into the page. Returns the number of bytes read, or ERROR if the read comes up short.
+ */
+static int read_segment_into_page(exec_image_t *image, int seg_vaddr, int seg_faddr, int seg_len, int page_addr) {
+  int start = (page_addr > seg_vaddr) ? page_addr : seg_vaddr;
+  int end = (page_addr + PAGESIZE < seg_vaddr + seg_len) ? page_addr + PAGESIZE : seg_vaddr + seg_len;
+  if (end <= start) {
+    return 0;
+  }
+  lseek(image->fd, seg_faddr + (start - seg_vaddr), SEEK_SET);
+  if (read(image->fd, (void *) start, end - start) != end - start) {
+    return ERROR;
+  }
+  return end - start;
+}
+
+/*
+ * Loads a not-yet-present page of the running process from its exec image. Since the process's region 1 table
+ * is the live one, we can map the frame writable and read straight into the user address, then drop to the
+ * protection LoadProgram recorded for the page.
+ */
+int page_in(pcb_t *process, int page) {
+  exec_image_t *image = process->image;
+  pte_t *user_page = &process->region_1_page_table[page];
+  int page_addr = VMEM_1_BASE + (page << PAGESHIFT);
+  int text_page = page - ((image->t_vaddr - VMEM_1_BASE) >> PAGESHIFT);
+
+  // another process running this executable already loaded this text page: just map its frame
+  int cached_frame = share_cached_text_frame(image, text_page);
+  if (cached_frame != FRAME_NONE) {
+    TracePrintf(5, "DEMAND_PAGING: Sharing cached text frame %d for page %d of pid %d\n",
+                cached_frame, page, process->pid);
+    user_page->valid = 1;
+    user_page->pfn = cached_frame;
+    process->page_flags[page] &= ~PAGE_FLAG_FILE;
+    WriteRegister(REG_TLB_FLUSH, page_addr);
+    return SUCCESS;
+  }
+
+  int new_frame = get_free_frame_or_evict(process->pid);
+  if (new_frame == MEMFULL) {
+    TracePrintf(1, "DEMAND_PAGING: Ran out of free frames to load page %d of pid %d!\n", page, process->pid);
+    return ERROR;
+  }
+  int final_prot = user_page->prot;
+  user_page->valid = 1;
+  user_page->prot = (PROT_READ | PROT_WRITE);
+  user_page->pfn = new_frame;
+  WriteRegister(REG_TLB_FLUSH, page_addr);
+
+  // the text and initialized data come from the file; the bss past id_end is zero-filled. The data read stops at
+  // id_end rather than at the end of id_npg pages, since what the file holds after the initialized data isn't bss.
+  int text_read = read_segment_into_page(image, image->t_vaddr, image->t_faddr, image->t_npg << PAGESHIFT, page_addr);
+  int data_read = read_segment_into_page(image, image->id_vaddr, image->id_faddr, image->id_end - image->id_vaddr,
+                                         page_addr);
+  if (text_read == ERROR || data_read == ERROR) {
+    TracePrintf(1, "DEMAND_PAGING: Unable to read page %d of pid %d from its executable\n", page, process->pid);
+    user_page->valid = 0;
+    user_page->prot = final_prot;
+    release_frame(frame_table_global, new_frame);
+    WriteRegister(REG_TLB_FLUSH, page_addr);
+    return ERROR;
+  }
+  if (text_read + data_read < PAGESIZE) {
+    // zero whatever the file didn't cover, which includes any bss in this page, even one it shares with data
+    int zero_start = page_addr;
+    if (data_read > 0) {
+      zero_start = (image->id_end > page_addr) ? image->id_end : page_addr;
+    }
+    else if (text_read > 0) {
+      zero_start = page_addr + text_read;
+    }
+    bzero((void *) zero_start, page_addr + PAGESIZE - zero_start);
+  }
+  TracePrintf(5, "DEMAND_PAGING: Loaded page %d of pid %d into frame %d (%d text bytes, %d data bytes)\n",
+              page, process->pid, new_frame, text_read, data_read);
+
+  user_page->prot = final_prot;
+  process->page_flags[page] &= ~PAGE_FLAG_FILE;
+  WriteRegister(REG_TLB_FLUSH, page_addr);
+
+  // remember read-only text pages so that the next process running this executable can share them
+  if (text_page >= 0 && text_page < image->t_npg && !(final_prot & PROT_WRITE)) {
+    share_frame(frame_table_global, new_frame);
+    image->text_frames[text_page] = new_frame;
+  }
+  return SUCCESS;
+}
@@ -0,0 +1,100 @@
+#ifndef CURRENT_CHUNGUS_DEMAND_PAGING_H
+#define CURRENT_CHUNGUS_DEMAND_PAGING_H
+
+#include <sys/stat.h>
+#include <ykernel.h>
+#include <load_info.h>
+#include "../data_structures/pcb.h"
+
+/*
+ * Demand-paged program loading.
+ *
+ * LoadProgram no longer reads the executable up front. Text, initialized data and bss pages are left
+ * invalid in the region 1 page table, tagged with PAGE_FLAG_FILE, and hold the protection they should end
+ * up with. The first touch of such a page traps into handle_trap_memory (or is caught by check_memory when
+ * the kernel touches it on the user's behalf), which calls page_in to read just that page from the
+ * executable.
+ *
+ * The open executable and the segment layout live in an exec_image, which is reference counted so that
+ * fork children, who inherit the not-yet-loaded pages, can keep faulting them in after the parent execs
+ * or exits.
+ *
+ * Images are also cached by file identity (device, inode and modification time), so every process running
+ * the same executable shares one image. Read-only text pages are loaded into a frame once and remembered
+ * in the image; later faults (and later execs, which map them straight away) share that frame instead of
+ * reading the file again. The cache holds its own reference to each text frame, and keeps up to
+ * EXEC_IMAGE_CACHE_IDLE images around after their last process has gone, so that re-execing a program
+ * (e.g. init restarting a test) still finds its text in memory.
+ */
+#define EXEC_IMAGE_CACHE_IDLE 4                        // unused images we keep cached before evicting the oldest
+
+typedef struct exec_image {
+  int fd;                                              // the open executable
+  int refcount;                                        // the number of processes using this image
+  dev_t dev;                                           // the file identity the image is cached under
+  ino_t ino;
+  time_t mtime;
+  int *text_frames;                                    // the frame holding each text page, or FRAME_NONE
+  struct exec_image *next;                             // the next image in the cache
+  int t_vaddr;                                         // text segment: where it goes, where it is in the file,
+  int t_faddr;                                         // and how many pages it takes up
+  int t_npg;
+  int id_vaddr;                                        // initialized data segment, as above
+  int id_faddr;
+  int id_npg;
+  int id_end;                                          // the end of initialized data; everything from here up to
+  int ud_end;                                          // ud_end (the bss) is zero-filled
+} exec_image_t;
+
+/*
+ * Returns a new reference to the image for the executable open on fd, taking ownership of fd. If the same file
+ * is already cached we use that image (and close fd); otherwise we create and cache a new one.
+ * Returns NULL if we can't allocate it (fd is left open in that case).
+ */
+exec_image_t *open_exec_image(int fd, struct load_info *li);
+
+/*
+ * Takes another reference to an image (e.g. for a fork child)
+ */
+exec_image_t *retain_exec_image(exec_image_t *image);
+
+/*
+ * Drops a reference to an image. An image no process uses stays cached until it is one of more than
+ * EXEC_IMAGE_CACHE_IDLE unused images, or memory runs short.
+ */
+void release_exec_image(exec_image_t *image);
+
+/*
+ * Returns the frame already holding text page text_page of this image with a new reference taken on it, or
+ * FRAME_NONE if the page isn't loaded yet
+ */
+int share_cached_text_frame(exec_image_t *image, int text_page);
+
+/*
+ * Evicts every cached image no process is using, freeing its text frames. Returns the number evicted.
+ */
+int evict_unused_exec_images();
+
+/*
+ * The frame allocators for everything but the kernel heap: get_free_frame and get_free_frames, except that when
+ * memory is full they evict the unused exec images (freeing their text frames) and try again. SetKernelBrk can't use
+ * these, since evicting an image frees kernel heap memory and would re-enter malloc.
+ * return the frame (or SUCCESS for get_free_frames_or_evict), or MEMFULL
+ */
+int get_free_frame_or_evict(int owner_pid);
+int get_free_frames_or_evict(int num_frames, int owner_pid, int *pfns);
+
+/*
+ * Returns true if page (a region 1 page index) of this process hasn't been loaded from its executable yet
+ */
+bool is_file_backed_page(pcb_t *process, int page);
+
+/*
+ * Loads a not-yet-present page of the RUNNING process from its exec image: takes a frame, fills it from the
+ * executable (zero-filling whatever the file doesn't cover) and maps it with the protection LoadProgram recorded.
+ *
+ * Returns SUCCESS, or ERROR if we are out of frames or the executable can't be read.
+ */
+int page_in(pcb_t *process, int page);
+
+#endif //CURRENT_CHUNGUS_DEMAND_PAGING_H
@@ -0,0 +1,107 @@
+#include <ykernel.h>
+#include "kstack_pool.h"
+#include "demand_paging.h"
+#include "../data_structures/pcb.h"
+#include "../data_structures/frame_table.h"
+
+extern frame_table_struct_t *frame_table_global;
+
+/*
+ * Takes a stack's worth of pinned frames from the frame table, evicting unused exec images if that frees enough.
+ * Returns SUCCESS or MEMFULL.
+ */
+static int allocate_stack_frames(int *pfns) {
+  if (get_free_frames_or_evict(KERNEL_STACK_PAGES, FRAME_OWNER_KERNEL, pfns) == MEMFULL) {
+    return MEMFULL;
+  }
+  for (int i=0; i<KERNEL_STACK_PAGES; i++) {
+    pin_frame(frame_table_global, pfns[i]);
+  }
+  return SUCCESS;
+}
+
+/*
+ * Create a pool keeping up to high_water stacks, filled as far as memory allows
+ */
+kstack_pool_t *create_kstack_pool(int high_water) {
+  kstack_pool_t *pool = malloc(sizeof(kstack_pool_t));
+  if (pool == NULL) {
+    TracePrintf(1, "KSTACK_POOL: Unable to allocate memory for the kernel stack pool\n");
+    return NULL;
+  }
+  pool->frames = malloc(sizeof(int) * KERNEL_STACK_PAGES * (high_water > 0 ? high_water : 1));
+  if (pool->frames == NULL) {
+    TracePrintf(1, "KSTACK_POOL: Unable to allocate memory for %d pooled kernel stacks\n", high_water);
+    free(pool);
+    return NULL;
+  }
+  pool->num_pooled = 0;
+  pool->high_water = high_water;
+  pool->num_reused = 0;
+  pool->num_allocated = 0;
+  pool->num_failures = 0;
+
+  while (pool->num_pooled < high_water &&
+         allocate_stack_frames(&pool->frames[pool->num_pooled * KERNEL_STACK_PAGES]) == SUCCESS) {
+    pool->num_pooled++;
+  }
+  TracePrintf(1, "KSTACK_POOL: Reserved %d of %d kernel stacks\n", pool->num_pooled, high_water);
+  return pool;
+}
+
+/*
+ * Give process a kernel stack, from the pool if it has one
+ */
+int take_kernel_stack(kstack_pool_t *pool, pcb_t *process) {
+  int fresh_frames[KERNEL_STACK_PAGES];
+  int *pfns;
+  if (pool->num_pooled > 0) {
+    pool->num_pooled--;
+    pool->num_reused++;
+    pfns = &pool->frames[pool->num_pooled * KERNEL_STACK_PAGES];
+  }
+  else if (allocate_stack_frames(fresh_frames) == SUCCESS) {
+    pool->num_allocated++;
+    pfns = fresh_frames;
+  }
+  else {
+    pool->num_failures++;
+    TracePrintf(1, "KSTACK_POOL: Out of kernel stacks (%d pooled of %d)\n", pool->num_pooled, pool->high_water);
+    return ERROR;
+  }
+
+  for (int i=0; i<KERNEL_STACK_PAGES; i++) {
+    process->kernel_stack[i].valid = 1;
+    process->kernel_stack[i].prot = (PROT_READ | PROT_WRITE);
+    process->kernel_stack[i].pfn = pfns[i];
+  }
+  return SUCCESS;
+}
+
+/*
+ * Take back a kernel stack, pooling it if there is room
+ */
+void return_kernel_stack(kstack_pool_t *pool, pte_t *kernel_stack) {
+  bool whole_stack = true;
+  for (int i=0; i<KERNEL_STACK_PAGES; i++) {
+    whole_stack = whole_stack && kernel_stack[i].valid;
+  }
+
+  if (whole_stack && pool->num_pooled < pool->high_water) {
+    int *pfns = &pool->frames[pool->num_pooled * KERNEL_STACK_PAGES];
+    for (int i=0; i<KERNEL_STACK_PAGES; i++) {
+      pfns[i] = kernel_stack[i].pfn;
+      kernel_stack[i].valid = 0;
+    }
+    pool->num_pooled++;
+    return;
+  }
+
+  for (int i=0; i<KERNEL_STACK_PAGES; i++) {
+    if (kernel_stack[i].valid) {
+      kernel_stack[i].valid = 0;
+      unpin_frame(frame_table_global, kernel_stack[i].pfn);
+      release_frame(frame_table_global, kernel_stack[i].pfn);
+    }
+  }
+}
@@ -0,0 +1,48 @@
+#ifndef CURRENT_CHUNGUS_KSTACK_POOL_H
+#define CURRENT_CHUNGUS_KSTACK_POOL_H
+
+#include <ykernel.h>
+#include "../data_structures/pcb.h"
+
+/*
+ * A pool of kernel stacks.
+ *
+ * Every process needs KERNEL_STACK_PAGES frames for its kernel stack. Rather than taking them from the
+ * frame table on every clone and handing them back on every exit, finished stacks are kept here (still
+ * pinned) and given straight to the next new process. Up to high_water stacks are kept; the pool is
+ * filled to that level at boot, and stacks returned beyond it go back to the frame table. The high water
+ * mark is set with the kstacks=N boot option.
+ *
+ * Stack frames belong to the kernel (FRAME_OWNER_KERNEL) for as long as they are pooled or in use.
+ */
+#define KERNEL_STACK_PAGES (KERNEL_STACK_MAXSIZE >> PAGESHIFT)
+#define KSTACK_POOL_DEFAULT_HIGH_WATER 8                // stacks kept for reuse unless the kstacks option says otherwise
+
+typedef struct kstack_pool {
+  int *frames;                                         // the frames of each pooled stack, KERNEL_STACK_PAGES apiece
+  int num_pooled;                                      // the number of stacks in the pool
+  int high_water;                                      // the most stacks we keep pooled
+  int num_reused;                                      // stacks handed out from the pool
+  int num_allocated;                                   // stacks handed out fresh from the frame table
+  int num_failures;                                    // requests we couldn't satisfy
+} kstack_pool_t;
+
+/*
+ * Create a pool keeping up to high_water stacks, and fill it with as many as memory allows (up to high_water).
+ * Returns NULL if we can't allocate it.
+ */
+kstack_pool_t *create_kstack_pool(int high_water);
+
+/*
+ * Give process a kernel stack: fills in process->kernel_stack with valid, pinned, read/write pages.
+ * Returns SUCCESS, or ERROR if the pool is empty and the frame table can't spare a stack.
+ */
+int take_kernel_stack(kstack_pool_t *pool, pcb_t *process);
+
+/*
+ * Take back the stack in kernel_stack (KERNEL_STACK_PAGES entries; invalid ones are skipped), leaving every
+ * entry invalid. The stack is pooled if there is room, and otherwise goes back to the frame table.
+ */
+void return_kernel_stack(kstack_pool_t *pool, pte_t *kernel_stack);
+
+#endif //CURRENT_CHUNGUS_KSTACK_POOL_H
@@ -11,9 +11,11 @@
 #include <load_info.h>
 #include <hardware.h>
 #include "../kernel_start.h"
+#include "../kernel_utils.h"
 #include "../data_structures/pcb.h"
 #include "../data_structures/frame_table.h"
 #include "../memory/check_memory.h"
+#include "../memory/demand_paging.h"
 
 /*
  * ==>> #include anything you need for your kernel here
@@ -44,7 +46,6 @@ LoadProgram(char *name, char *args[], pcb_t* proc)
   int data_pg1;
   int data_npg;
   int stack_npg;
-  long segment_size;
   char *argbuf;
 
   /*
@@ -178,6 +179,7 @@ LoadProgram(char *name, char *args[], pcb_t* proc)
    */
   if (cp2 == NULL) {
     TracePrintf(1, "Malloc returned null when generating an argbuf in load_program\n");
+    close(fd);
     return ERROR;
   }
 
@@ -189,9 +191,40 @@ LoadProgram(char *name, char *args[], pcb_t* proc)
   TracePrintf(3, "Finished copying the arguments in load_program\n");
 
   /*
-   * Set up the page tables for the process so that we can read the
-   * program into memory.  Get the right number of physical pages
-   * allocated, and set them all to writable.
+   * The new image keeps the executable open so that text and data pages can be
+   * read in as they are first touched, rather than all up front. If another
+   * process is (or recently was) running the same file, we share its image.
+   */
+  exec_image_t *image = open_exec_image(fd, &li);
+  if (image == NULL) {
+    free(argbuf);
+    close(fd);
+    return ERROR;
+  }
+
+  /*
+   * Spawn loads a process that isn't running yet. Everything above read the
+   * caller's address space; from here on we write the new process's, so make
+   * its region 1 table the live one (restoring the caller's when we are done).
+   */
+  bool install_page_table = (proc != running_process);
+
+  /*
+   * A VFork child is still running in its parent's address space. Give that
+   * back (waking the parent) and load into its own, empty region 1 instead.
+   */
+  if (proc->vfork_parent != NULL) {
+    return_borrowed_address_space(proc);
+    install_page_table = true;
+  }
+  if (install_page_table) {
+    WriteRegister(REG_PTBR1, (int) proc->region_1_page_table);
+    WriteRegister(REG_TLB_FLUSH, TLB_FLUSH_1);
+  }
+
+  /*
+   * Set up the page tables for the process. Text and data pages are left
+   * invalid and file-backed; only the stack gets frames now.
    */
   TracePrintf(3, "Setting up page table for the process\n");
   pte_t page;
@@ -206,59 +239,70 @@ LoadProgram(char *name, char *args[], pcb_t* proc)
     if (proc->region_1_page_table[ind].valid) {
       // mark invalid
       proc->region_1_page_table[ind].valid = 0;
-      // clear the frame
-      frame_table_global->frame_table[proc->region_1_page_table[ind].pfn] = 0;
+      // drop our mapping of the frame (it may still be shared copy-on-write with a relative)
+      release_frame(frame_table_global, proc->region_1_page_table[ind].pfn);
     }
     proc->region_1_page_table[ind].prot = (PROT_WRITE);
+    proc->page_flags[ind] = 0;
   }
+  release_exec_image(proc->image);
+  proc->image = image;
 
   /*
    * ==>> Then, build up the new region1.
    * ==>> (See the LoadProgram diagram in the manual.)
    */
 
+  // grab the stack frames up front, in the largest contiguous runs the allocator has
+  int pfns[MAX_PT_LEN];
+  int rc = get_free_frames_or_evict(stack_npg, proc->pid, pfns);
+  if (rc == MEMFULL) {
+    TracePrintf(1, "Not enough free frames for a stack of %d pages\n", stack_npg);
+    free(argbuf);
+    if (proc != running_process) {
+      WriteRegister(REG_PTBR1, (int) running_process->region_1_page_table);
+      WriteRegister(REG_TLB_FLUSH, TLB_FLUSH_1);
+    }
+    return KILL;
+  }
+  int next_pfn = 0;
+
 
 
   /*
-   * ==>> First, text. Allocate "li.t_npg" physical pages and map them starting>
-   * ==>> the "text_pg1" page in region 1 address space.
-   * ==>> These pages should be marked valid, with a protection of
-   * ==>> (PROT_READ | PROT_WRITE).
+   * First, text. The "li.t_npg" pages starting at "text_pg1" get a protection
+   * of (PROT_READ | PROT_EXEC). Pages the image already has in memory are mapped
+   * to those shared frames right away; the rest are left invalid and file-backed
+   * until handle_trap_memory loads them.
    */
-  TracePrintf(4, "Allocating space for %d text pages, starting at page %d, in table with %d pages\n",
+  TracePrintf(4, "Mapping %d file-backed text pages, starting at page %d, in table with %d pages\n",
               li.t_npg, text_pg1, page_table_reg_1_size
               );
 
-  int nextIndex = 0;
   for (int i = 0; i < li.t_npg; i++) {
-    proc->region_1_page_table[i+text_pg1].valid = 1;
-    proc->region_1_page_table[i+text_pg1].prot = (PROT_READ | PROT_WRITE);
-    // gets a new free frame
-    int pfn = get_free_frame(frame_table_global->frame_table, frame_table_global->frame_table_size, nextIndex);
-    if (pfn == -1) {
-      return KILL;
+    proc->region_1_page_table[i+text_pg1].prot = (PROT_READ | PROT_EXEC);
+    int cached_frame = share_cached_text_frame(image, i);
+    if (cached_frame != FRAME_NONE) {
+      proc->region_1_page_table[i+text_pg1].valid = 1;
+      proc->region_1_page_table[i+text_pg1].pfn = cached_frame;
+    }
+    else {
+      proc->region_1_page_table[i+text_pg1].valid = 0;
+      proc->page_flags[i+text_pg1] = PAGE_FLAG_FILE;
     }
-    proc->region_1_page_table[i+text_pg1].pfn = pfn;
-    nextIndex = pfn;
   }
 
   /*
-   * ==>> Then, data. Allocate "data_npg" physical pages and map them starting >
-   * ==>> the  "data_pg1" in region 1 address space.
-   * ==>> These pages should be marked valid, with a protection of
-   * ==>> (PROT_READ | PROT_WRITE).
+   * Then, data. The "data_npg" pages starting at "data_pg1" are also file-backed,
+   * ending up (PROT_READ | PROT_WRITE). Pages past the initialized data are
+   * zero-filled when they are loaded, which takes care of the bss.
    */
-  TracePrintf(4, "Allocating space for %d data pages, starting at page %d, in table with %d pages\n",
+  TracePrintf(4, "Mapping %d file-backed data pages, starting at page %d, in table with %d pages\n",
               data_npg, data_pg1, page_table_reg_1_size);
   for (int i = 0; i < data_npg; i++) {
-    proc->region_1_page_table[i+data_pg1].valid = 1;
+    proc->region_1_page_table[i+data_pg1].valid = 0;
     proc->region_1_page_table[i+data_pg1].prot = (PROT_READ | PROT_WRITE);
-    int pfn = get_free_frame(frame_table_global->frame_table, frame_table_global->frame_table_size, nextIndex);
-    if (pfn == -1) {
-      return KILL;
-    }
-    proc->region_1_page_table[i+data_pg1].pfn = pfn;
-    nextIndex = pfn;
+    proc->page_flags[i+data_pg1] = PAGE_FLAG_FILE;
   }
 
   /*
@@ -272,12 +316,7 @@ LoadProgram(char *name, char *args[], pcb_t* proc)
   for (int i = 0; i < stack_npg; i++) {
     proc->region_1_page_table[MAX_PT_LEN - stack_npg + i].valid = 1;
     proc->region_1_page_table[MAX_PT_LEN - stack_npg + i].prot = (PROT_READ | PROT_WRITE);
-    int pfn = get_free_frame(frame_table_global->frame_table, frame_table_global->frame_table_size, nextIndex);
-    if (pfn == -1) {
-      return KILL;
-    }
-    proc->region_1_page_table[MAX_PT_LEN - stack_npg + i].pfn = pfn;
-    nextIndex = pfn;
+    proc->region_1_page_table[MAX_PT_LEN - stack_npg + i].pfn = pfns[next_pfn++];
   }
 
   // set page table limit
@@ -290,50 +329,9 @@ LoadProgram(char *name, char *args[], pcb_t* proc)
    */
 
   /*
-   * Read the text from the file into memory.
+   * Text and data are read from the file (and the bss zeroed) page by page as
+   * the process touches them; see memory/demand_paging.c.
    */
-  TracePrintf(4, "Reading text from file into memory\n");
-  lseek(fd, li.t_faddr, SEEK_SET);
-  segment_size = li.t_npg << PAGESHIFT;
-  if (read(fd, (void *) li.t_vaddr, segment_size) != segment_size) {
-    close(fd);
-    return KILL;   // see ykernel.h
-  }
-
-  /*
-   * Read the data from the file into memory.
-   */
-  lseek(fd, li.id_faddr, 0);
-  segment_size = li.id_npg << PAGESHIFT;
-
-
-  if (read(fd, (void *) li.id_vaddr, segment_size) != segment_size) {
-    close(fd);
-    return KILL;
-  }
-
-
-  close(fd);                    /* we've read it all now */
-  TracePrintf(4, "Reading complete\n");
-
-
-  /*
-   * ==>> Above, you mapped the text pages as writable, so this code could write
-   * ==>> the new text there.
-   *
-   * ==>> But now, you need to change the protections so that the machine can e>
-   * ==>> the text.
-   *
-   * ==>> For each text page in region1, change the protection to (PROT_READ | >
-   * ==>> If any of these page table entries is also in the TLB,
-   * ==>> you will need to flush the old mapping.
-   */
-  TracePrintf(3, "Finalizing page table protections...\n");
-  for (int ind=0; ind < li.t_npg; ind++) {
-    proc->region_1_page_table[ind+text_pg1].prot = (PROT_READ | PROT_EXEC);
-  }
-  WriteRegister(REG_TLB_FLUSH, TLB_FLUSH_1);
-
   for (int i = 0; i < page_table_reg_1_size; i++) {
     if (proc->region_1_page_table[i].valid) {
       TracePrintf(4, "Addr: %x to %x, Valid: %d, Pfn: %d\n",
@@ -345,13 +343,6 @@ LoadProgram(char *name, char *args[], pcb_t* proc)
     }
   }
 
-  /*
-   * Zero out the uninitialized data area
-   */
-  TracePrintf(3, "Zeroing uninitialized data\n");
-  TracePrintf(3, "Zeroing from %x to %x;\n", li.id_end, li.ud_end);
-  bzero((void*)li.id_end, li.ud_end - li.id_end);
-
   /*
    * Set the entry point in the process's UserContext
    */
@@ -380,6 +371,10 @@ LoadProgram(char *name, char *args[], pcb_t* proc)
   *cpp++ = NULL;                        /* a NULL pointer for an empty envp */
   TracePrintf(1, "Finished loading the program\n");
 
+  // hand region 1 back to the caller if we were loading someone else
+  if (proc != running_process) {
+    WriteRegister(REG_PTBR1, (int) running_process->region_1_page_table);
+  }
   WriteRegister(REG_TLB_FLUSH, TLB_FLUSH_ALL);
 
   return SUCCESS;
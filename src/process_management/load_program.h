@@ -15,6 +15,10 @@
  *  to the process or PCB structure for the process into which the program
  *  is to be loaded.
  *
+ *  name and args are always read from the running process. proc may be a
+ *  process that isn't running (for Spawn), in which case its region 1 table
+ *  is installed while we build it and the caller's is restored afterwards.
+ *
  *  r0 is only true for the init process.
  */
 
@@ -0,0 +1,175 @@
+#include <ykernel.h>
+#include "scheduler.h"
+
+/*
+ * Create an empty scheduler with this policy. Returns NULL if we can't allocate it.
+ */
+scheduler_t *create_scheduler(int policy) {
+  scheduler_t *scheduler = malloc(sizeof(scheduler_t));
+  if (scheduler == NULL) {
+    TracePrintf(1, "CREATE_SCHEDULER: Unable to allocate memory for the scheduler\n");
+    return NULL;
+  }
+  bzero(scheduler, sizeof(scheduler_t));
+  scheduler->policy = policy;
+  for (int level=0; level<MLFQ_LEVELS; level++) {
+    scheduler->levels[level] = create_queue();
+    if (scheduler->levels[level] == NULL) {
+      TracePrintf(1, "CREATE_SCHEDULER: Unable to allocate the ready queue for level %d\n", level);
+      for (int i=0; i<level; i++) {
+        delete_queue(scheduler->levels[i]);
+      }
+      free(scheduler);
+      return NULL;
+    }
+  }
+  return scheduler;
+}
+
+/*
+ * The number of ticks a process gets per turn
+ */
+static int quantum(scheduler_t *scheduler, pcb_t *process) {
+  if (scheduler->policy == SCHED_MLFQ) {
+    return process->quantum << process->sched_level;
+  }
+  return process->quantum;
+}
+
+/*
+ * Set a process's priority (PRIORITY_HIGHEST..PRIORITY_LOWEST), and with it its quantum and how often it gets a turn
+ */
+void set_priority(pcb_t *process, int priority) {
+  process->priority = priority;
+  process->quantum = PRIORITY_QUANTUM(priority);
+  process->turns_passed = 0;
+}
+
+/*
+ * Puts a process at the back of its level, with a fresh quantum
+ */
+static void enqueue(scheduler_t *scheduler, pcb_t *process) {
+  process->ticks_used = 0;
+  add_to_queue(scheduler->levels[process->sched_level], process);
+  scheduler->num_ready++;
+}
+
+/*
+ * Make a process that was blocked (or is brand new) ready to run
+ */
+void add_ready(scheduler_t *scheduler, pcb_t *process) {
+  if (scheduler->policy == SCHED_MLFQ && process->sched_level > 0) {
+    process->sched_level--;
+    scheduler->num_promotions++;
+    TracePrintf(3, "SCHEDULER: Woken process %d moves up to level %d\n", process->pid, process->sched_level);
+  }
+  enqueue(scheduler, process);
+}
+
+/*
+ * Put a process that was preempted by the clock back with the ready processes
+ */
+void requeue_preempted(scheduler_t *scheduler, pcb_t *process) {
+  // only a process that used its whole quantum drops; one preempted early for a higher level keeps its place
+  if (scheduler->policy == SCHED_MLFQ && process->ticks_used >= quantum(scheduler, process) &&
+      process->sched_level < MLFQ_LEVELS - 1) {
+    process->sched_level++;
+    scheduler->num_demotions++;
+    TracePrintf(3, "SCHEDULER: Process %d used its quantum and drops to level %d\n", process->pid, process->sched_level);
+  }
+  enqueue(scheduler, process);
+}
+
+/*
+ * Is anything ready to run?
+ */
+bool has_ready(scheduler_t *scheduler) {
+  return scheduler->num_ready > 0;
+}
+
+/*
+ * Takes the next process to run off a non-empty level. Each process at the front that hasn't yet let
+ * PRIORITY_TURNS_PASSED(priority) others go ahead of it passes, and goes to the back; if they all pass, the front
+ * one runs anyway.
+ */
+static pcb_t *remove_from_level(queue_t *level) {
+  int num_queued = level->size;
+  for (int i=0; i<num_queued; i++) {
+    pcb_t *process = remove_from_queue(level);
+    if (process->turns_passed >= PRIORITY_TURNS_PASSED(process->priority)) {
+      process->turns_passed = 0;
+      return process;
+    }
+    process->turns_passed++;
+    add_to_queue(level, process);
+  }
+  pcb_t *process = remove_from_queue(level);
+  process->turns_passed = 0;
+  return process;
+}
+
+/*
+ * Remove and return the process that should run next, or NULL if nothing is ready
+ */
+pcb_t *remove_next_ready(scheduler_t *scheduler) {
+  for (int level=0; level<MLFQ_LEVELS; level++) {
+    if (!is_empty(scheduler->levels[level])) {
+      scheduler->num_ready--;
+      return remove_from_level(scheduler->levels[level]);
+    }
+  }
+  return NULL;
+}
+
+/*
+ * Moves every ready process (and the running one) back to level 0
+ */
+static void boost_all(scheduler_t *scheduler, pcb_t *running) {
+  for (int level=1; level<MLFQ_LEVELS; level++) {
+    pcb_t *process = remove_from_queue(scheduler->levels[level]);
+    while (process != NULL) {
+      process->sched_level = 0;
+      add_to_queue(scheduler->levels[0], process);
+      process = remove_from_queue(scheduler->levels[level]);
+    }
+  }
+  if (running != NULL) {
+    running->sched_level = 0;
+  }
+  scheduler->num_boosts++;
+  TracePrintf(3, "SCHEDULER: Boosted every process back to level 0\n");
+}
+
+/*
+ * Returns true if a process on a higher level than this one is ready
+ */
+static bool higher_level_ready(scheduler_t *scheduler, int level) {
+  for (int higher=0; higher<level; higher++) {
+    if (!is_empty(scheduler->levels[higher])) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/*
+ * Charge the running process for a clock tick (and age everyone). Returns whether it should give up the CPU.
+ */
+bool scheduler_tick(scheduler_t *scheduler, pcb_t *running) {
+  if (running != NULL) {
+    running->ticks_used++;
+  }
+  if (scheduler->policy != SCHED_MLFQ) {
+    return running == NULL || running->ticks_used >= quantum(scheduler, running);
+  }
+
+  scheduler->ticks_since_boost++;
+  if (scheduler->ticks_since_boost >= MLFQ_BOOST_INTERVAL) {
+    scheduler->ticks_since_boost = 0;
+    boost_all(scheduler, running);
+  }
+  if (running == NULL) {
+    return true;
+  }
+  return running->ticks_used >= quantum(scheduler, running) || higher_level_ready(scheduler, running->sched_level);
+}
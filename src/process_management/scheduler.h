@@ -0,0 +1,81 @@
+#ifndef CURRENT_CHUNGUS_SCHEDULER_H
+#define CURRENT_CHUNGUS_SCHEDULER_H
+
+#include <ykernel.h>
+#include "../data_structures/pcb.h"
+#include "../data_structures/queue.h"
+#include "../syscalls/custom_syscalls.h"
+
+#define SCHED_ROUND_ROBIN 0                            // one FIFO queue, one tick per turn
+#define SCHED_MLFQ 1                                   // multi-level feedback queue
+
+#define MLFQ_LEVELS 4                                  // level 0 runs first
+#define MLFQ_BOOST_INTERVAL 50                         // ticks between moving every process back up to level 0
+
+#define PRIORITY_QUANTUM(priority) ((priority) + 1)     // ticks per turn at each priority
+// turns a process at each priority lets others have between its own: (p + 1)^2 - 1
+#define PRIORITY_TURNS_PASSED(priority) (PRIORITY_QUANTUM(priority) * PRIORITY_QUANTUM(priority) - 1)
+
+/*
+ * The ready processes, and the policy for choosing among them. The policy is set with the sched boot option.
+ *
+ * Each process has a quantum set by its priority (see SetPriority): PRIORITY_QUANTUM(priority) ticks, so
+ * batch jobs given a low priority are switched out less often. The clock only preempts a process once its
+ * quantum is used up. To keep those long slices from also buying a bigger share of the CPU, a process at priority p
+ * reaching the front of its queue lets PRIORITY_TURNS_PASSED(p) others go first: it runs p + 1 times as long but
+ * (p + 1)^2 times less often, so a CPU-bound process at priority p gets about 1/(p + 1) of the CPU a priority 0 one
+ * does. If everything ready is passing, the front process runs anyway, so a lone batch job doesn't leave the CPU idle.
+ *
+ * Round robin keeps everything on levels[0].
+ *
+ * MLFQ scales a process's quantum by 2^i on level i. A process that uses up its quantum drops a level,
+ * and one woken up after blocking (on a TTY, pipe, lock, cvar, Delay...) rises a level, so I/O-bound processes
+ * get ahead of CPU hogs. A running process is also preempted early when something on a higher level is ready.
+ * Every MLFQ_BOOST_INTERVAL ticks everything is moved back to level 0, so CPU hogs can't starve.
+ */
+typedef struct scheduler {
+  int policy;                                          // SCHED_ROUND_ROBIN or SCHED_MLFQ
+  queue_t *levels[MLFQ_LEVELS];                        // ready processes by level; round robin only uses level 0
+  int num_ready;                                       // processes on any level
+  int ticks_since_boost;
+  int num_demotions;                                   // quanta used up on levels that could drop further
+  int num_promotions;                                  // wakeups that moved a process up a level
+  int num_boosts;                                      // times everything went back to level 0
+} scheduler_t;
+
+/*
+ * Create an empty scheduler with this policy. Returns NULL if we can't allocate it.
+ */
+scheduler_t *create_scheduler(int policy);
+
+/*
+ * Make a process that was blocked (or is brand new) ready to run
+ */
+void add_ready(scheduler_t *scheduler, pcb_t *process);
+
+/*
+ * Put a process that was preempted by the clock back with the ready processes
+ */
+void requeue_preempted(scheduler_t *scheduler, pcb_t *process);
+
+/*
+ * Is anything ready to run?
+ */
+bool has_ready(scheduler_t *scheduler);
+
+/*
+ * Remove and return the process that should run next, or NULL if nothing is ready
+ */
+pcb_t *remove_next_ready(scheduler_t *scheduler);
+
+/*
+ * Set a process's priority (PRIORITY_HIGHEST..PRIORITY_LOWEST), and with it its quantum and how often it gets a turn
+ */
+void set_priority(pcb_t *process, int priority);
+
+/*
+ * Charge the running process for a clock tick (and age everyone). Returns whether it should give up the CPU.
+ */
+bool scheduler_tick(scheduler_t *scheduler, pcb_t *running);
+
+#endif //CURRENT_CHUNGUS_SCHEDULER_H
@@ -0,0 +1,47 @@
+//
+// Our own syscalls, beyond the ones in the Yalnix spec
+//
+
+#ifndef CURRENT_CHUNGUS_CUSTOM_SYSCALLS
+#define CURRENT_CHUNGUS_CUSTOM_SYSCALLS
+
+/*
+ * Yalnix only leaves us three spare trap codes (YALNIX_CUSTOM_0..2), so all of our own syscalls go
+ * through YALNIX_CUSTOM_0: the first register says which call it is and the rest are its arguments.
+ * Both the kernel and user programs (through test_processes/yuser_custom.h) include this file, so
+ * it should only ever hold defines.
+ */
+#define CUSTOM_SPAWN 1                                 // Spawn(char *file, char **argvec)
+#define CUSTOM_VFORK 2                                 // VFork(void)
+#define CUSTOM_SET_PRIORITY 3                          // SetPriority(int pid, int priority)
+#define CUSTOM_GET_PRIORITY 4                          // GetPriority(int pid)
+#define CUSTOM_SHARE_PAGES 5                           // SharePages(void *addr, int len)
+#define CUSTOM_FUTEX_WAIT 6                            // FutexWait(int *addr, int expected)
+#define CUSTOM_FUTEX_WAKE 7                            // FutexWake(int *addr, int num_waiters)
+#define CUSTOM_GET_TICKS 8                             // GetTicks(void)
+#define CUSTOM_RWLOCK_INIT 9                           // RwLockInit(int *rwlock_idp)
+#define CUSTOM_RW_ACQUIRE_READ 10                      // RwAcquireRead(int rwlock_id)
+#define CUSTOM_RW_ACQUIRE_WRITE 11                     // RwAcquireWrite(int rwlock_id)
+#define CUSTOM_RW_RELEASE 12                           // RwRelease(int rwlock_id)
+#define CUSTOM_BARRIER_INIT 13                         // BarrierInit(int *barrier_idp, int num_parties)
+#define CUSTOM_BARRIER_WAIT 14                         // BarrierWait(int barrier_id)
+#define CUSTOM_CVAR_TIMED_WAIT 15                      // CvarTimedWait(int cvar_id, int lock_id, int ticks)
+#define CUSTOM_ACQUIRE_TIMEOUT 16                      // AcquireTimeout(int lock_id, int ticks)
+#define CUSTOM_PIPE_INIT_SIZED 17                      // PipeInitSized(int *pipe_idp, int capacity)
+#define CUSTOM_PIPE_RESIZE 18                          // PipeResize(int pipe_id, int capacity)
+
+// process priorities, nice-style: 0 is the default and the highest, and larger numbers are more batch-like
+#define PRIORITY_HIGHEST 0
+#define PRIORITY_LOWEST 7
+#define PRIORITY_DEFAULT PRIORITY_HIGHEST
+
+// FutexWait's return when the word no longer held the value the caller expected
+#define FUTEX_CHANGED 1
+
+// what CvarTimedWait and AcquireTimeout return when they run out of ticks (ERROR is -1)
+#define TIMED_OUT -2
+
+// the most a sized pipe can hold (a whole number of pages); PipeInit pipes hold PIPE_BUFFER_LEN bytes
+#define PIPE_MAX_CAPACITY 65536
+
+#endif //CURRENT_CHUNGUS_CUSTOM_SYSCALLS
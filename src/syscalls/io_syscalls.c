@@ -10,7 +10,7 @@
 extern pcb_t* running_process;
 extern pcb_t* idle_process;
 extern bool is_idle;
-extern queue_t* ready_queue;
+extern scheduler_t *scheduler_global;
 extern void *trap_handler[16];
 extern pte_t *region_0_page_table;
 extern tty_object_t *tty_objects[NUM_TERMINALS];
@@ -6,11 +6,12 @@
 #include <ykernel.h>
 #include "../data_structures/tty.h"
 #include "../data_structures/queue.h"
+#include "../process_management/scheduler.h"
 
 extern pcb_t* running_process;
 extern pcb_t* idle_process;                                           // the special idle process; use when nothing is in ready queue
 extern bool is_idle;                                                  // if is_idle, we won't put the process back on the ready queue
-extern queue_t* ready_queue;
+extern scheduler_t *scheduler_global;
 extern void *trap_handler[16];
 extern pte_t *region_0_page_table;
 extern tty_object_t *tty_objects[NUM_TERMINALS];
@@ -20,29 +20,62 @@ int handle_PipeInit(int *pipe_idp)
     return ERROR;
   }
 
-  unsigned int next_id = ++max_pipe_id;
+  // create a new pipe; this also gives it an id in the pipe table
+  pipe_t* new_pipe = create_pipe(PIPE_BUFFER_LEN);
+  if (new_pipe == NULL) {
+    TracePrintf(1, "HANDLE_PIPE_INIT: failed to create a new pipe\n");
+    return ERROR;
+  }
 
-  if (next_id > max_possible_pipe_id) {
-    TracePrintf(1, "Run out of ID space to allocate more pipes\n");
+  pipe_idp[0] = new_pipe->pipe_id;
+  return SUCCESS;
+}
+
+/*
+ * Create a new pipe that holds capacity bytes, rounded up to whole pages; save its identifier at *pipe_idp
+ */
+int handle_PipeInitSized(int *pipe_idp, int capacity)
+{
+  TracePrintf(1, "HANDLE_PIPE_INIT_SIZED: attempting to create a new pipe of %d bytes\n", capacity);
+
+  int rounded_capacity = round_pipe_capacity(capacity);
+  if (rounded_capacity == ERROR) {
+    TracePrintf(1, "HANDLE_PIPE_INIT_SIZED: a pipe can't hold %d bytes\n", capacity);
+    return ERROR;
+  }
+  if (check_memory(pipe_idp, sizeof (int), false, true, false, false) == ERROR) {
     return ERROR;
   }
 
-  // create a new pipe
-  pipe_t* new_pipe = create_pipe(next_id);
+  pipe_t* new_pipe = create_pipe(rounded_capacity);
   if (new_pipe == NULL) {
-    TracePrintf(1, "HANDLE_PIPE_INIT: failed to create a new pipe\n");
+    TracePrintf(1, "HANDLE_PIPE_INIT_SIZED: failed to create a new pipe\n");
     return ERROR;
   }
 
-  // stick it at the head of the pipe linked list
-  pipe_t* prev_ll = pipes;
-  pipes = new_pipe;
-  new_pipe->next_pipe = prev_ll;
-  if (prev_ll != NULL) {
-    prev_ll->prev_pipe = new_pipe;
+  pipe_idp[0] = new_pipe->pipe_id;
+  return SUCCESS;
+}
+
+/*
+ * Change how much the pipe identified by pipe_id holds, rounded up to whole pages
+ */
+int handle_PipeResize(int pipe_id, int capacity)
+{
+  TracePrintf(1, "HANDLE_PIPE_RESIZE: Resizing pipe with id %d to %d bytes\n", pipe_id, capacity);
+
+  int rounded_capacity = round_pipe_capacity(capacity);
+  pipe_t* found_pipe = find_pipe(pipe_id);
+  if (rounded_capacity == ERROR || found_pipe == NULL) {
+    TracePrintf(1, "HANDLE_PIPE_RESIZE: Can't resize pipe with id %d to %d bytes\n", pipe_id, capacity);
+    return ERROR;
+  }
+  if (resize_pipe(found_pipe, rounded_capacity) == ERROR) {
+    return ERROR;
   }
 
-  pipe_idp[0] = next_id;
+  // a writer blocked on the full pipe may fit now
+  unblock_pcb_on_pipe_write(found_pipe);
   return SUCCESS;
 }
 
@@ -86,12 +119,7 @@ int handle_PipeRead(int pipe_id, void *buf, int len)
   TracePrintf(1, "HANDLE_PIPE_READ: Reading bytes from pipe with id %d\n", pipe_id);
 
   // read bytes from the pipe into *buf, until we either hit len or the number of bytes in found_pipe
-  int buf_loc = 0;
-  while (found_pipe->cur_size > 0 && buf_loc < len) {
-    char new_char = read_byte(found_pipe);
-    ((char *)buf)[buf_loc] = new_char;
-    buf_loc++;
-  }
+  int num_read = pipe_read(found_pipe, (char *)buf, len);
 
   TracePrintf(1, "HANDLE_PIPE_READ: Finished reading bytes from pipe with id %d\n", pipe_id);
 
@@ -103,10 +131,10 @@ int handle_PipeRead(int pipe_id, void *buf, int len)
   pcb_t* new_writer = remove_from_queue(found_pipe->blocked_write_queue);
   TracePrintf(1, "HANDLE_PIPE_READ: Removed from queue\n");
   if (new_writer != NULL) {
-    add_to_queue(ready_queue, new_writer);
+    add_ready(scheduler_global, new_writer);
   }
 
-  return buf_loc+1;
+  return num_read;
 }
 
 /*
@@ -133,28 +161,15 @@ int handle_PipeWrite(int pipe_id, void *buf, int len)
   int buf_index = 0;
   int num_left = len;
   while (num_left > 0) {
-    // calculate the number of bytes left to write
-    //     checks to see how much free space the pipe buffer has
-    int next_byte_cluster_size = found_pipe->max_size - found_pipe->cur_size;
-    if (num_left < next_byte_cluster_size) {
-      next_byte_cluster_size = num_left;
-    }
-
-    num_left -= next_byte_cluster_size;
-    //     write all bytes we can into the pipe buffer, checking return code
-    int rc;
-    while (next_byte_cluster_size > 0) {
-      char next_byte = ((char *)buf)[buf_index];
-      rc = write_byte(found_pipe, next_byte);
-      if (rc == ERROR) {
-        return ERROR;
-      }
-      next_byte_cluster_size--;
-      buf_index++;
-    }
+    // write as much as the pipe has room for, flipping whole pages in rather than copying them
+    int num_written = pipe_write(found_pipe, (char *)buf + buf_index, num_left);
+    buf_index += num_written;
+    num_left -= num_written;
 
     if (num_left > 0) {
       TracePrintf(1, "HANDLE_PIPE_WRITE: Pipe with id %d is full; blocking process\n", pipe_id);
+      //   a reader may have blocked on the empty pipe before we filled it; it has to drain the pipe for us
+      unblock_pcb_on_pipe_read(found_pipe);
       //   put the caller in the blocked queue of the pipe
       block_pcb_on_pipe_write(found_pipe, running_process);
       //   swap a new process into the ready slot for execution
@@ -168,7 +183,7 @@ int handle_PipeWrite(int pipe_id, void *buf, int len)
   // unblock things that were blocked on read/write
   pcb_t* new_reader = remove_from_queue(found_pipe->blocked_read_queue);
   if (new_reader != NULL) {
-    add_to_queue(ready_queue, new_reader);
+    add_ready(scheduler_global, new_reader);
   }
 
   return len;
@@ -199,7 +214,7 @@ int handle_PipeKill(int pipe_id, int kill_children) {
       delete_process(next_child, ERROR, false);
     }
     else {
-      add_to_queue(ready_queue, next_child);
+      add_ready(scheduler_global, next_child);
     }
     next_child = remove_from_queue(found_pipe->blocked_read_queue);
   }
@@ -211,23 +226,12 @@ int handle_PipeKill(int pipe_id, int kill_children) {
       delete_process(next_child, ERROR, false);
     }
     else {
-      add_to_queue(ready_queue, next_child);
+      add_ready(scheduler_global, next_child);
     }
     next_child = remove_from_queue(found_pipe->blocked_write_queue);
   }
 
-  // stitch the pipe list together
-  if (found_pipe == pipes) {
-    pipes = found_pipe->next_pipe;
-  }
-  if (found_pipe->prev_pipe != NULL) {
-    found_pipe->prev_pipe->next_pipe = found_pipe->next_pipe;
-  }
-  if (found_pipe->next_pipe != NULL) {
-    found_pipe->next_pipe->prev_pipe = found_pipe->prev_pipe;
-  }
-
-  // delete the pipe
+  // take the pipe out of the pipe table and delete it
   delete_pipe(found_pipe);
 
   return SUCCESS;
@@ -12,6 +12,18 @@ buffer.) In case of any error, the value ERROR is returned.
  */
 int handle_PipeInit(int *pipe_idp);
 
+/*
+ * Create a new pipe that holds capacity bytes, rounded up to whole pages; save its identifier at *pipe_idp. In case
+ * of any error (including a capacity over PIPE_MAX_CAPACITY), the value ERROR is returned.
+ */
+int handle_PipeInitSized(int *pipe_idp, int capacity);
+
+/*
+ * Change how much the pipe identified by pipe_id holds, rounded up to whole pages. The unread bytes are kept, so the
+ * pipe can't shrink below them. In case of any error, the value ERROR is returned.
+ */
+int handle_PipeResize(int pipe_id, int capacity);
+
 /*
  * Read len consecutive bytes from the named pipe into the buffer starting at address buf, following the standard
 semantics:
@@ -6,20 +6,25 @@
 #include "../data_structures/frame_table.h"
 #include "../debug_utils/debug.h"
 #include "../memory/check_memory.h"
+#include "../memory/cow.h"
+#include "../memory/demand_paging.h"
+#include "../memory/kstack_pool.h"
+#include "../process_management/load_program.h"
 
 extern frame_table_struct_t *frame_table_global;
 extern pcb_t* running_process;
 extern pcb_t* idle_process;                                           // the special idle process; use when nothing is in ready queue
 extern bool is_idle;                                                  // if is_idle, we won't put the process back on the ready queue
-extern queue_t* ready_queue;
+extern scheduler_t *scheduler_global;
 extern void *trap_handler[16];
 extern pte_t *region_0_page_table;
+extern kstack_pool_t *kstack_pool_global;
 
   /*
   * Fork the process and create a new, separate address space.
   * We give the child a unique pid and copy over the user context and region 1 page table.
-  * Then we walk through the page table and copy the contents of valid pages into new frames.
-  * TODO: Copy on write, eventually
+  * Instead of copying every valid page up front, parent and child share each frame copy-on-write:
+  * writable pages become read-only in both, and the first write to one is copied in handle_trap_memory.
   */
 int handle_Fork(void)
 {
@@ -30,63 +35,37 @@ int handle_Fork(void)
   if (child_pcb == NULL) {
     return ERROR;
   }
+  // take the child's kernel stack before touching our pages, so that running out is easy to back out of
+  if (take_kernel_stack(kstack_pool_global, child_pcb) == ERROR) {
+    free_pcb(child_pcb);
+    return ERROR;
+  }
 
   int child_pid = helper_new_pid(child_pcb->region_1_page_table);
   child_pcb->pid = child_pid;
   child_pcb->parent = running_process;
+  set_priority(child_pcb, running_process->priority);
+  child_pcb->brk_floor = running_process->brk_floor;
   memcpy(child_pcb->uctxt, running_process->uctxt, sizeof(UserContext));
   child_pcb->rc = 0;
   running_process->rc = running_process->pid;
 
-  // walk through the page table and copy over all allocated pages into a buffer page (with a new pfn)
-  // Note: because our TLB caches pages, we need to either move our buffer page down or overwrite that single page
-  // in our TLB. I choose the latter.
-  int bufpage_index = (KERNEL_STACK_BASE >> PAGESHIFT) - 1;
-  pte_t *bufpage = &region_0_page_table[bufpage_index];
+  // walk through the page table and share every valid page with the child, copy-on-write.
+  // Pages not yet loaded from the executable are inherited as they are, along with the image they come from.
   for (int i=0; i<region_1_page_table_size; i++) {
     if (running_process->region_1_page_table[i].valid) {
-      int new_frame = get_free_frame(
-          frame_table_global->frame_table, 
-          frame_table_global->frame_table_size, 
-          0
-      );
-
-      if (new_frame == MEMFULL) {
-        TracePrintf(1, "FORK HANDLER: Ran out of free frames to allocate!\n");
-        // clear the already-allocated frames on the page table
-        delete_r1_page_table(child_pcb, i-1);
-        // retire the new pcb
-        helper_retire_pid(child_pcb->pid);
-        free(child_pcb);
-        return ERROR;
-      }
-
-      // use the page below the stack as a buffer to write stack pages into frames
-      bufpage->valid = 1;
-      bufpage->prot = (PROT_READ | PROT_WRITE);
-      bufpage->pfn = new_frame;
-      // keep the existing permissions, but update the pfn of the page
-      child_pcb->region_1_page_table[i].valid = 1;
-      child_pcb->region_1_page_table[i].prot = running_process->region_1_page_table[i].prot; 
-      child_pcb->region_1_page_table[i].pfn = bufpage->pfn; 
-      // write bytes in question to the frame 
-      TracePrintf(5, "FORK HANDLER: Writing bytes %08x from %p to %p\n",
-                  * (int *)(VMEM_1_BASE + (i << PAGESHIFT)),
-                  (VMEM_1_BASE + (i << PAGESHIFT)), (VMEM_0_BASE + (bufpage_index << PAGESHIFT)));
-      TracePrintf(5, "FORK HANDLER: Bufpage: Addr %x, valid %d, prot %d, pfn %d\n",
-                  bufpage_index << PAGESHIFT, bufpage->valid, bufpage->prot, bufpage->pfn);
-      memcpy((void *)(VMEM_0_BASE + (bufpage_index << PAGESHIFT)), (void *)(VMEM_1_BASE + (i << PAGESHIFT)), PAGESIZE);
-      // flush the page from the TLB so it doesn't cache and overwrite the same frame
-      bufpage->valid = 0;
-      WriteRegister(REG_TLB_FLUSH, (int) (VMEM_0_BASE + (bufpage_index << PAGESHIFT)));
-//      WriteRegister(REG_TLB_FLUSH, TLB_FLUSH_ALL);
+      share_page_cow(running_process, child_pcb, i);
     }
     else {
-      child_pcb->region_1_page_table[i].valid = 0; 
+      child_pcb->region_1_page_table[i] = running_process->region_1_page_table[i];
+      child_pcb->page_flags[i] = running_process->page_flags[i];
     }
   }
+  child_pcb->image = retain_exec_image(running_process->image);
+  // the parent's writable pages just became read-only, so drop any stale writable TLB entries
+  WriteRegister(REG_TLB_FLUSH, TLB_FLUSH_1);
 
-  add_to_queue(ready_queue, child_pcb);
+  add_ready(scheduler_global, child_pcb);
   // return the right thing for fork
   int rc = clone_process(child_pcb);
 
@@ -137,6 +116,108 @@ int handle_Exec(char *filename, char **argvec)
   return rc;
 }
 
+/*
+ * Fork for a child that is just going to Exec or Exit. Rather than sharing every page copy-on-write,
+ * the child borrows our region 1 page table outright (along with its page flags and exec image), so
+ * this costs the same however big we are. Since the child runs on our user stack and data, we stay
+ * blocked until it gives them back in LoadProgram or delete_process.
+ */
+int handle_VFork(void)
+{
+  TracePrintf(1, "VFORK_HANDLER: Attempting to vfork the running process\n");
+
+  pcb_t *child_pcb = allocate_pcb();
+  if (child_pcb == NULL) {
+    return ERROR;
+  }
+  if (take_kernel_stack(kstack_pool_global, child_pcb) == ERROR) {
+    free_pcb(child_pcb);
+    return ERROR;
+  }
+  // the pid goes with the child's own (still empty) table, which use_own_region_1 puts back when it stops borrowing
+  child_pcb->pid = helper_new_pid(child_pcb->region_1_page_table);
+
+  // the child doesn't use a region 1 of its own until it execs
+  child_pcb->region_1_page_table = running_process->region_1_page_table;
+  child_pcb->page_flags = running_process->page_flags;
+  child_pcb->image = running_process->image;
+  child_pcb->vfork_parent = running_process;
+
+  child_pcb->parent = running_process;
+  set_priority(child_pcb, running_process->priority);
+  child_pcb->brk_floor = running_process->brk_floor;
+  memcpy(child_pcb->uctxt, running_process->uctxt, sizeof(UserContext));
+  child_pcb->rc = 0;
+  running_process->rc = child_pcb->pid;
+  running_process->waitingForVforkChild = true;
+
+  add_ready(scheduler_global, child_pcb);
+  int rc = clone_process(child_pcb);
+  if (running_process == child_pcb) {
+    return rc;
+  }
+
+  // off the ready queue until the child is done with our address space
+  while (running_process->waitingForVforkChild) {
+    TracePrintf(1, "VFORK_HANDLER: Parent %d blocking until child %d execs or exits\n", running_process->pid, rc);
+    install_next_from_queue(running_process, 1);
+  }
+  TracePrintf(1, "VFORK_HANDLER: Parent %d has its address space back\n", running_process->pid);
+  return rc;
+}
+
+/*
+ * Frees a pcb that handle_Spawn built but never got to run
+ */
+static void discard_spawned_pcb(pcb_t *child_pcb) {
+  destroy_process_no_switch(child_pcb);
+  free_pcb(child_pcb);
+}
+
+/*
+ * Fork and exec in one step. The Fork-then-Exec pattern shares the whole parent address space
+ * copy-on-write only for LoadProgram to throw it away again; instead we start the child with an
+ * empty region 1 table and load the program straight into it. The child then gets a copy of our
+ * kernel stack, so that it returns from this syscall into its new program.
+ */
+int handle_Spawn(char *filename, char **argvec)
+{
+  TracePrintf(1, "SPAWN_HANDLER: Attempting to spawn a new process with provided arguments\n");
+
+  // allocate_pcb leaves region 1 empty, so LoadProgram has nothing to throw away
+  pcb_t *child_pcb = allocate_pcb();
+  if (child_pcb == NULL) {
+    return ERROR;
+  }
+  if (take_kernel_stack(kstack_pool_global, child_pcb) == ERROR) {
+    free_pcb(child_pcb);
+    return ERROR;
+  }
+
+  child_pcb->pid = helper_new_pid(child_pcb->region_1_page_table);
+  child_pcb->parent = running_process;
+  set_priority(child_pcb, running_process->priority);
+  // the child starts from our user context; LoadProgram replaces its pc and stack
+  memcpy(child_pcb->uctxt, running_process->uctxt, sizeof(UserContext));
+
+  int rc = LoadProgram(filename, argvec, child_pcb);
+  if (rc != SUCCESS) {
+    // unlike Exec, a failed load only costs the child; we report it and keep going
+    TracePrintf(1, "SPAWN_HANDLER: Loading '%s' failed with exit code %d\n", filename, rc);
+    discard_spawned_pcb(child_pcb);
+    return ERROR;
+  }
+  child_pcb->rc = 0;
+  running_process->rc = child_pcb->pid;
+
+  add_ready(scheduler_global, child_pcb);
+  rc = clone_process(child_pcb);
+
+  TracePrintf(1, "SPAWN_HANDLER: Back from clone in pid %d; return code is %d\n", running_process->pid, rc);
+  print_reg_1_page_table(running_process, 5, "POST SPAWN");
+  return rc;
+}
+
 /*
  * Terminates the process, saving status for later retrieval by the parent
  * all other resources are freed
@@ -149,6 +230,10 @@ void handle_Exit(int status)
   // if idle process exits, halt the machine
   if (running_process->pid == 1) {
     TracePrintf(0, "EXIT: Idle process is exiting; we're halting the kernel\n");
+    // report the stats we kept once, now that nothing else will run
+    print_frame_stats(3);
+    print_clock_stats(3);
+    print_scheduler_stats(3);
     Halt();
   }
 
@@ -305,7 +390,8 @@ int handle_Brk(void *addr)
   TracePrintf(5, "=====Region 1 Page Table Before SetBrk (%d pages)=====\n", region_1_page_table_size);
   print_reg_1_page_table(running_process, 5, "");
 
-  //find the brk
+  //find the brk, starting above the data segment (whose pages may not be loaded yet)
+  current_brk_page = running_process->brk_floor;
   while (!brkfound && current_brk_page < region_1_page_table_size){
     if (!region_1_page_table[current_brk_page].valid) {
       brkfound = true;
@@ -321,29 +407,21 @@ int handle_Brk(void *addr)
     return ERROR;
   }
 
-  int first_possible_free_frame = 0;
   if (addr_page > current_brk_page) {
     TracePrintf(3, "SETBRK: Will try to find memory to allocate more frames\n");
-    // error out if we don't have enough memory
-    if (addr_page-current_brk_page > get_num_free_frames(frame_table_global->frame_table,
-                                                                  frame_table_global->frame_table_size)
-        ) {
+    // error out if we don't have enough memory; otherwise take the whole growth in as few runs as we can
+    int new_frames[MAX_PT_LEN];
+    if (get_free_frames_or_evict(addr_page-current_brk_page, running_process->pid, new_frames) == MEMFULL) {
       TracePrintf(1, "SETBRK: SetBrk did not find enough memory for the whole malloc to succeed\n");
       return ERROR;
     }
 
     TracePrintf(3, "SETBRK: SetBrk found enough memory for malloc to succeed\n");
+    int next_frame = 0;
     while (addr_page > current_brk_page) {
-      int new_frame_num = get_free_frame(frame_table_global->frame_table,
-                                          frame_table_global->frame_table_size,
-                                          first_possible_free_frame);
-      if (new_frame_num == -1) {
-        TracePrintf(1, "SETBRK: SetBrk was unable to allocate a new frame...\n");
-        return ERROR;
-      }
       region_1_page_table[current_brk_page].valid = 1;
       region_1_page_table[current_brk_page].prot = (PROT_READ | PROT_WRITE);
-      region_1_page_table[current_brk_page].pfn = new_frame_num;
+      region_1_page_table[current_brk_page].pfn = new_frames[next_frame++];
       current_brk_page++;
     }
 
@@ -364,10 +442,14 @@ int handle_Brk(void *addr)
 
     while (addr_page < current_brk_page) {
       TracePrintf(1, "SETBRK: Deleting a page from the page table...\n");
+      // current_brk_page is the first unmapped page, so the page to discard is the one below it
+      current_brk_page--;
       int discard_frame_number = region_1_page_table[current_brk_page].pfn;
-      frame_table_global->frame_table[discard_frame_number] = 0;
+      // the frame may still be shared copy-on-write with a relative
+      release_frame(frame_table_global, discard_frame_number);
       region_1_page_table[current_brk_page].valid = 0;
-      current_brk_page--;
+      running_process->page_flags[current_brk_page] = 0;
+      WriteRegister(REG_TLB_FLUSH, (int) (VMEM_1_BASE + (current_brk_page << PAGESHIFT)));
     }
 
     TracePrintf(1, "SETBRK: Brk set to %d pages\n", current_brk_page);
@@ -376,6 +458,15 @@ int handle_Brk(void *addr)
   }
 }
 
+/*
+ * Timer callback for Delay: the clock trap calls this once the process's ticks are up
+ */
+static void wake_delayed_process(tick_timer_t *timer) {
+  pcb_t *process = (pcb_t *) timer->arg;
+  TracePrintf(1, "DELAY: Delayed process with id %d will be put in the ready queue\n", process->pid);
+  add_ready(scheduler_global, process);
+}
+
 /*
  * The calling process is blocked until at least clock ticks clock interrupts have occurred after the call. Upon
 completion of the delay, the value 0 is returned.
@@ -395,26 +486,94 @@ int handle_Delay(int clock_ticks)
     return SUCCESS;
   }
 
-  // make sure that we don't bring straggling processes along
-  running_process->next_pcb = NULL;
-  running_process->prev_pcb = NULL;
+  // otherwise, block the process for clock_ticks: the clock trap puts it back in the ready queue
+  init_timer(&running_process->delay_timer, &wake_delayed_process, running_process);
+  add_timer(timer_wheel_global, &running_process->delay_timer, clock_ticks);
 
-  // otherwise, block the process for clock_ticks (put in delay collection)
-  running_process->delayed_clock_cycles = clock_ticks;
+  pcb_t* old_process = running_process;
 
-  // stick in at the head of the linked list
-  running_process->next_pcb = delayed_processes;
-  delayed_processes = running_process;
+  // get the next process from the queue
+  install_next_from_queue(old_process, 1);
 
-  if (delayed_processes->next_pcb != NULL) {
-    // set the backpointer of the previous head
-    delayed_processes->next_pcb->prev_pcb = delayed_processes;
+  return SUCCESS;
+}
+/*
+ * Returns the caller's pcb if pid is the caller's, or a live child's; NULL otherwise
+ */
+static pcb_t *find_self_or_child(int pid) {
+  if (pid == running_process->pid) {
+    return running_process;
   }
+  for (pcb_t *child = running_process->children; child != NULL; child = child->next_sibling) {
+    if (child->pid == pid && !child->hasExited) {
+      return child;
+    }
+  }
+  return NULL;
+}
 
-  pcb_t* old_process = running_process;
+/*
+ * Sets the priority of the caller or one of its children. The new quantum applies from the process's next turn.
+ * returns SUCCESS, or ERROR if pid isn't the caller or a live child, or the priority is out of range
+ */
+int handle_SetPriority(int pid, int priority)
+{
+  TracePrintf(1, "SET_PRIORITY: Setting the priority of pid %d to %d\n", pid, priority);
+  if (priority < PRIORITY_HIGHEST || priority > PRIORITY_LOWEST) {
+    TracePrintf(1, "SET_PRIORITY: Priority %d is out of range\n", priority);
+    return ERROR;
+  }
+  pcb_t *process = find_self_or_child(pid);
+  if (process == NULL) {
+    TracePrintf(1, "SET_PRIORITY: Pid %d is neither the caller nor one of its live children\n", pid);
+    return ERROR;
+  }
+  set_priority(process, priority);
+  return SUCCESS;
+}
 
-  // get the next process from the queue
-  install_next_from_queue(old_process, 1);
+/*
+ * returns the priority of the caller or one of its children, or ERROR if pid isn't the caller or a live child
+ */
+int handle_GetPriority(int pid)
+{
+  pcb_t *process = find_self_or_child(pid);
+  if (process == NULL) {
+    TracePrintf(1, "GET_PRIORITY: Pid %d is neither the caller nor one of its live children\n", pid);
+    return ERROR;
+  }
+  return process->priority;
+}
 
+/*
+ * Marks the pages holding [addr, addr+len) shared with any children forked from now on: share_page_cow leaves
+ * them writable in both processes. Meant for globals and heap that processes use to talk to each other, e.g. futex
+ * words; the flag goes away with the page when Brk unmaps it or the process execs.
+ */
+int handle_SharePages(void *addr, int len)
+{
+  TracePrintf(1, "SHARE_PAGES: Sharing %d bytes at %p with future children\n", len, addr);
+  if (len <= 0) {
+    return ERROR;
+  }
+  // check_memory for write access pages in file-backed pages and breaks COW sharing, so every page we tag is private
+  // and writable before it gets PAGE_FLAG_SHARED
+  if (check_memory(addr, len, false, true, false, false) == ERROR) {
+    TracePrintf(1, "SHARE_PAGES: %d bytes at %p aren't all writable user memory\n", len, addr);
+    return ERROR;
+  }
+  int first_page = ((unsigned int) addr - VMEM_1_BASE) >> PAGESHIFT;
+  int last_page = ((unsigned int) addr + len - 1 - VMEM_1_BASE) >> PAGESHIFT;
+  for (int i=first_page; i<=last_page; i++) {
+    running_process->page_flags[i] |= PAGE_FLAG_SHARED;
+  }
   return SUCCESS;
-}
\ No newline at end of file
+}
+
+/*
+ * returns the number of clock ticks since boot
+ */
+int handle_GetTicks(void)
+{
+  return (int) timer_wheel_global->now;
+}
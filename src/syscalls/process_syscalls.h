@@ -19,6 +19,18 @@ int handle_Fork(void);
  */
 int handle_Exec(char *filename, char **argvec);
 
+/*
+ * Create a new process running filename with arguments argvec, without copying the caller's address space
+ * returns the child's pid to the caller; ERROR if the program can't be loaded (the caller carries on)
+ */
+int handle_Spawn(char *filename, char **argvec);
+
+/*
+ * Fork without copying: the child runs in the caller's address space, and the caller is blocked until the
+ * child calls Exec or Exit. Returns like Fork.
+ */
+int handle_VFork(void);
+
 /*
  * Terminates the process, saving status for later retrieval by the parent
  * all other resources are freed
@@ -53,4 +65,27 @@ ERROR is returned instead.
  */
 int handle_Delay(int clock_ticks);
 
+/*
+ * Sets the priority of the caller or one of its children, which sets its quantum and how often it gets a turn
+ * returns SUCCESS, or ERROR if pid isn't the caller or a live child, or the priority is out of range
+ */
+int handle_SetPriority(int pid, int priority);
+
+/*
+ * returns the priority of the caller or one of its children, or ERROR if pid isn't the caller or a live child
+ */
+int handle_GetPriority(int pid);
+
+/*
+ * Marks the pages holding [addr, addr+len) shared, so that children forked from now on map them writable instead
+ * of copy-on-write, and see the caller's writes (and it theirs)
+ * returns SUCCESS, or ERROR if any of the range isn't writable user memory
+ */
+int handle_SharePages(void *addr, int len);
+
+/*
+ * returns the number of clock ticks since boot
+ */
+int handle_GetTicks(void);
+
 #endif //CURRENT_CHUNGUS_PROCESS_SYSCALL_HANDLERS
\ No newline at end of file
@@ -6,6 +6,11 @@
 #include <ykernel.h>
 #include "../data_structures/lock.h"
 #include "../data_structures/cvar.h"
+#include "../data_structures/futex.h"
+#include "../data_structures/sem.h"
+#include "../data_structures/rwlock.h"
+#include "../data_structures/barrier.h"
+#include "custom_syscalls.h"
 #include "../memory/check_memory.h"
 #include "../kernel_start.h"
 
@@ -68,23 +73,14 @@ int handle_LockKill(int lock_id, int kill_children) {
       delete_process(next_child, ERROR, false);
     }
     else {
-      add_to_queue(ready_queue, next_child);
+      // a timed waiter's timer mustn't look for it on the lock's queue once the queue is gone
+      cancel_timer(timer_wheel_global, &next_child->delay_timer);
+      add_ready(scheduler_global, next_child);
     }
     next_child = remove_from_queue(found_lock->blocked_queue);
   }
 
-  // stitch the lock list together
-  if (found_lock == locks) {
-    locks = found_lock->next_lock;
-  }
-  if (found_lock->prev_lock != NULL) {
-    found_lock->prev_lock->next_lock = found_lock->next_lock;
-  }
-  if (found_lock->next_lock != NULL) {
-    found_lock->next_lock->prev_lock = found_lock->prev_lock;
-  }
-
-  // delete the lock
+  // take the lock out of the lock table and delete it
   delete_lock(found_lock);
 
   return SUCCESS;
@@ -117,7 +113,7 @@ ERROR is returned.
  */
 int handle_CvarSignal(int cvar_id) {
   TracePrintf(1, "HANDLE_CVAR_SIGNAL: signaling one waiter to wake up\n");
-  // signal one of the waiters on the cvar to wake up, and put it in the queue waiting to run
+  // signal one of the waiters on the cvar to wake up: it runs once it has its lock back
   cvar_t* cvar = find_cvar(cvar_id);
   if (cvar == NULL) {
     TracePrintf(1, "HANDLE_CVAR_SIGNAL: Unable to find a cvar with id %d\n", cvar_id);
@@ -125,10 +121,11 @@ int handle_CvarSignal(int cvar_id) {
   }
   pcb_t* next_pcb = remove_from_queue(cvar->blocked_queue);
 
-  // stick the next pcb in the queue
+  // move the waiter over to its lock, rather than waking it to contend for the lock
   if (next_pcb != NULL) {
-    add_to_queue(ready_queue, next_pcb);
+    acquire_for_waiter(next_pcb->cvar_lock_id, next_pcb);
   }
+  return SUCCESS;
 }
 
 /*
@@ -137,7 +134,7 @@ value ERROR is returned.
  */
 int handle_CvarBroadcast(int cvar_id){
   TracePrintf(1, "HANDLE_CVAR_BROADCAST: waking up all waiters\n");
-  // wake up all of the waiters, and put them in the queue waiting to run
+  // wake up all of the waiters: at most one gets the lock and runs, and the rest queue up on the lock in order
   cvar_t* cvar = find_cvar(cvar_id);
   if (cvar == NULL) {
     TracePrintf(1, "HANDLE_CVAR_BROADCAST: Unable to find a cvar with id %d\n", cvar_id);
@@ -145,7 +142,7 @@ int handle_CvarBroadcast(int cvar_id){
   }
   pcb_t* next_pcb = remove_from_queue(cvar->blocked_queue);
   while (next_pcb != NULL) {
-    add_to_queue(ready_queue, next_pcb);
+    acquire_for_waiter(next_pcb->cvar_lock_id, next_pcb);
     next_pcb = remove_from_queue(cvar->blocked_queue);
   }
 
@@ -176,14 +173,54 @@ int handle_CvarWait(int cvar_id, int lock_id) {
   }
   TracePrintf(1, "HANDLE_CVAR_WAIT: Passed lock release\n");
 
-  // block the running process
+  // block the running process; a signal or broadcast gets us the lock back before we run again
+  running_process->cvar_lock_id = lock_id;
   add_to_queue(cvar->blocked_queue, running_process);
   install_next_from_queue(running_process, 1);
 
+  // if we were woken up some other way (e.g. the cvar was deleted), we still have to acquire the lock ourselves
   TracePrintf(1, "HANDLE_CVAR_WAIT: Back from block on cvar; now acquiring lock\n");
   return acquire(lock_id);
 }
 
+/*
+ * Like CvarWait, but gives up waiting for a signal after ticks clock ticks. The timeout only covers the wait for a
+ * signal: once signaled, or timed out, we wait for the lock as long as it takes, like CvarWait.
+ */
+int handle_CvarTimedWait(int cvar_id, int lock_id, int ticks) {
+  TracePrintf(1, "HANDLE_CVAR_TIMED_WAIT: Blocking on cvar with id %d for up to %d ticks\n", cvar_id, ticks);
+
+  cvar_t* cvar = find_cvar(cvar_id);
+  if (cvar == NULL || ticks < 0) {
+    TracePrintf(1, "HANDLE_CVAR_TIMED_WAIT: Can't wait %d ticks on cvar with id %d\n", ticks, cvar_id);
+    return ERROR;
+  }
+  if (release(lock_id) == ERROR) {
+    TracePrintf(1, "HANDLE_CVAR_TIMED_WAIT: Unable to release a lock with id %d\n", lock_id);
+    return ERROR;
+  }
+
+  bool timed_out = true;
+  if (ticks > 0) {
+    running_process->cvar_lock_id = lock_id;
+    timed_out = block_with_timeout(cvar->blocked_queue, ticks);
+  }
+
+  // a signal moved us onto the lock's queue (or gave us the lock already); a timeout woke us without it
+  int rc = acquire(lock_id);
+  if (rc == ERROR) {
+    return ERROR;
+  }
+  return timed_out ? TIMED_OUT : SUCCESS;
+}
+
+/*
+ * Like Acquire, but gives up after ticks clock ticks
+ */
+int handle_AcquireTimeout(int lock_id, int ticks) {
+  return acquire_timeout(lock_id, ticks);
+}
+
 /*
 * Kill cvar by cvar id, and any queued children. If necessary,
 * we could specify a kill/don't kill option in our input args.
@@ -208,26 +245,353 @@ int handle_CvarKill(int cvar_id, int kill_children) {
       delete_process(next_child, ERROR, false);
     }
     else {
-      add_to_queue(ready_queue, next_child);
+      cancel_timer(timer_wheel_global, &next_child->delay_timer);
+      add_ready(scheduler_global, next_child);
     }
     next_child = remove_from_queue(found_cvar->blocked_queue);
   }
 
-  // stitch the cvar list together
-  if (found_cvar == cvars) {
-    cvars = found_cvar->next_cvar;
+  // take the cvar out of the cvar table and delete it
+  delete_cvar(found_cvar);
+
+  return SUCCESS;
+}
+
+/*
+ * Create a new semaphore with value units; save its identifier at *sem_idp. In case of any error, the value ERROR
+ * is returned.
+ */
+int handle_SemInit(int *sem_idp, int value) {
+  TracePrintf(1, "HANDLE_SEM_INIT: Creating a new semaphore with value %d\n", value);
+  if (value < 0) {
+    TracePrintf(1, "HANDLE_SEM_INIT: A semaphore can't start with a negative value\n");
+    return ERROR;
+  }
+  if (check_memory(sem_idp, sizeof (int), false, true, false, false) == ERROR) {
+    return ERROR;
   }
-  if (found_cvar->prev_cvar != NULL) {
-    found_cvar->prev_cvar->next_cvar = found_cvar->next_cvar;
+
+  semaphore_t* sem = create_sem_any_id(value);
+  if (sem == NULL) {
+    TracePrintf(1, "HANDLE_SEM_INIT: Unable to create a new semaphore\n");
+    return ERROR;
   }
-  if (found_cvar->next_cvar != NULL) {
-    found_cvar->next_cvar->prev_cvar = found_cvar->prev_cvar;
+  sem_idp[0] = sem->id;
+  return SUCCESS;
+}
+
+/*
+ * Give a unit back to the semaphore identified by sem_id. Like release, we hand the unit straight to the oldest
+ * waiter rather than bumping the value and letting it race for it, so waiters are served in FIFO order.
+ */
+int handle_SemUp(int sem_id) {
+  semaphore_t* sem = find_sem(sem_id);
+  if (sem == NULL) {
+    TracePrintf(1, "HANDLE_SEM_UP: Unable to find a semaphore with id %d\n", sem_id);
+    return ERROR;
   }
 
-  // delete the cvar
-  delete_cvar(found_cvar);
+  pcb_t* next_pcb = remove_from_queue(sem->blocked_queue);
+  if (next_pcb != NULL) {
+    TracePrintf(1, "HANDLE_SEM_UP: Handing a unit of semaphore %d to process %d\n", sem_id, next_pcb->pid);
+    add_ready(scheduler_global, next_pcb);
+  }
+  else {
+    sem->value++;
+  }
+  return SUCCESS;
+}
 
+/*
+ * Take a unit from the semaphore identified by sem_id, blocking until SemUp hands us one
+ */
+int handle_SemDown(int sem_id) {
+  semaphore_t* sem = find_sem(sem_id);
+  if (sem == NULL) {
+    TracePrintf(1, "HANDLE_SEM_DOWN: Unable to find a semaphore with id %d\n", sem_id);
+    return ERROR;
+  }
+
+  if (sem->value > 0) {
+    sem->value--;
+    return SUCCESS;
+  }
+  TracePrintf(1, "HANDLE_SEM_DOWN: Process %d waiting on semaphore %d\n", running_process->pid, sem_id);
+  add_to_queue(sem->blocked_queue, running_process);
+  install_next_from_queue(running_process, 1);
+
+  // SemUp gave us its unit before waking us; if the semaphore was killed instead, we got nothing
+  if (find_sem(sem_id) != sem) {
+    return ERROR;
+  }
   return SUCCESS;
 }
 
+/*
+ * Kill semaphore by id, and any queued children waiting on it.
+ *
+ * kill_children = 0  --> don't kill
+ * kill_children = 1  --> do kill
+ */
+int handle_SemKill(int sem_id, int kill_children) {
+  TracePrintf(1, "HANDLE_SEM_KILL: Attempting to delete a semaphore with id %d\n", sem_id);
+
+  semaphore_t* found_sem = find_sem(sem_id);
+  if (found_sem == NULL) {
+    TracePrintf(1, "HANDLE_SEM_KILL: Unable to find a semaphore with id %d\n", sem_id);
+    return ERROR;
+  }
+
+  pcb_t* next_child = remove_from_queue(found_sem->blocked_queue);
+  while (next_child != NULL) {
+    if (kill_children == 1) {
+      delete_process(next_child, ERROR, false);
+    }
+    else {
+      add_ready(scheduler_global, next_child);
+    }
+    next_child = remove_from_queue(found_sem->blocked_queue);
+  }
+
+  // take the semaphore out of the semaphore table and delete it
+  delete_sem(found_sem);
+
+  return SUCCESS;
+}
+
+/*
+ * Create a new reader-writer lock; save its identifier at *rwlock_idp. In case of any error, the value ERROR is
+ * returned.
+ */
+int handle_RwLockInit(int *rwlock_idp) {
+  TracePrintf(1, "HANDLE_RWLOCK_INIT: Creating a new reader-writer lock!\n");
+
+  if (check_memory(rwlock_idp, sizeof (int), false, true, false, false) == ERROR) {
+    return ERROR;
+  }
+
+  rwlock_t* rwlock = create_rwlock_any_id();
+  if (rwlock == NULL) {
+    TracePrintf(1, "HANDLE_RWLOCK_INIT: Unable to create a new reader-writer lock\n");
+    return ERROR;
+  }
+  rwlock_idp[0] = rwlock->id;
+  return SUCCESS;
+}
+
+/*
+ * Acquire the reader-writer lock identified by rwlock_id for reading
+ */
+int handle_RwAcquireRead(int rwlock_id) {
+  return rw_acquire_read(rwlock_id);
+}
+
+/*
+ * Acquire the reader-writer lock identified by rwlock_id for writing
+ */
+int handle_RwAcquireWrite(int rwlock_id) {
+  return rw_acquire_write(rwlock_id);
+}
+
+/*
+ * Release the reader-writer lock identified by rwlock_id
+ */
+int handle_RwRelease(int rwlock_id) {
+  return rw_release(rwlock_id);
+}
+
+/*
+ * Kill reader-writer lock by id, and any queued children waiting to read or write it.
+ *
+ * kill_children = 0  --> don't kill
+ * kill_children = 1  --> do kill
+ */
+int handle_RwLockKill(int rwlock_id, int kill_children) {
+  TracePrintf(1, "HANDLE_RWLOCK_KILL: Attempting to delete a reader-writer lock with id %d\n", rwlock_id);
+
+  rwlock_t* found_rwlock = find_rwlock(rwlock_id);
+  if (found_rwlock == NULL) {
+    TracePrintf(1, "HANDLE_RWLOCK_KILL: Unable to find a reader-writer lock with id %d\n", rwlock_id);
+    return ERROR;
+  }
+
+  queue_t* queues[] = {found_rwlock->read_queue, found_rwlock->write_queue};
+  for (int i=0; i<2; i++) {
+    pcb_t* next_child = remove_from_queue(queues[i]);
+    while (next_child != NULL) {
+      if (kill_children == 1) {
+        delete_process(next_child, ERROR, false);
+      }
+      else {
+        add_ready(scheduler_global, next_child);
+      }
+      next_child = remove_from_queue(queues[i]);
+    }
+  }
+
+  // take the lock out of the rwlock table and delete it
+  delete_rwlock(found_rwlock);
+
+  return SUCCESS;
+}
+
+/*
+ * Create a new barrier for num_parties processes; save its identifier at *barrier_idp. In case of any error, the
+ * value ERROR is returned.
+ */
+int handle_BarrierInit(int *barrier_idp, int num_parties) {
+  TracePrintf(1, "HANDLE_BARRIER_INIT: Creating a new barrier for %d processes\n", num_parties);
+  if (num_parties < 1) {
+    TracePrintf(1, "HANDLE_BARRIER_INIT: A barrier needs at least one process\n");
+    return ERROR;
+  }
+  if (check_memory(barrier_idp, sizeof (int), false, true, false, false) == ERROR) {
+    return ERROR;
+  }
+
+  barrier_t* barrier = create_barrier_any_id(num_parties);
+  if (barrier == NULL) {
+    TracePrintf(1, "HANDLE_BARRIER_INIT: Unable to create a new barrier\n");
+    return ERROR;
+  }
+  barrier_idp[0] = barrier->id;
+  return SUCCESS;
+}
+
+/*
+ * Wait at the barrier identified by barrier_id. The last process to arrive doesn't block: it moves everyone else
+ * onto the ready queue in one go, and the barrier is ready for the next round straight away.
+ */
+int handle_BarrierWait(int barrier_id) {
+  barrier_t* barrier = find_barrier(barrier_id);
+  if (barrier == NULL) {
+    TracePrintf(1, "HANDLE_BARRIER_WAIT: Unable to find a barrier with id %d\n", barrier_id);
+    return ERROR;
+  }
+
+  if (barrier->num_waiting + 1 < barrier->num_parties) {
+    TracePrintf(1, "HANDLE_BARRIER_WAIT: Process %d waiting at barrier %d (%d of %d)\n", running_process->pid,
+                barrier_id, barrier->num_waiting + 1, barrier->num_parties);
+    barrier->num_waiting++;
+    add_to_queue(barrier->blocked_queue, running_process);
+    install_next_from_queue(running_process, 1);
+    // we were either let go by the last arrival, or the barrier was killed
+    return (find_barrier(barrier_id) == barrier) ? SUCCESS : ERROR;
+  }
+
+  TracePrintf(1, "HANDLE_BARRIER_WAIT: Process %d is the last at barrier %d; releasing %d waiters\n",
+              running_process->pid, barrier_id, barrier->num_waiting);
+  pcb_t* next_pcb = remove_from_queue(barrier->blocked_queue);
+  while (next_pcb != NULL) {
+    add_ready(scheduler_global, next_pcb);
+    next_pcb = remove_from_queue(barrier->blocked_queue);
+  }
+  barrier->num_waiting = 0;
+  return SUCCESS;
+}
+
+/*
+ * Kill barrier by id, and any queued children waiting at it.
+ *
+ * kill_children = 0  --> don't kill
+ * kill_children = 1  --> do kill
+ */
+int handle_BarrierKill(int barrier_id, int kill_children) {
+  TracePrintf(1, "HANDLE_BARRIER_KILL: Attempting to delete a barrier with id %d\n", barrier_id);
+
+  barrier_t* found_barrier = find_barrier(barrier_id);
+  if (found_barrier == NULL) {
+    TracePrintf(1, "HANDLE_BARRIER_KILL: Unable to find a barrier with id %d\n", barrier_id);
+    return ERROR;
+  }
+
+  pcb_t* next_child = remove_from_queue(found_barrier->blocked_queue);
+  while (next_child != NULL) {
+    if (kill_children == 1) {
+      delete_process(next_child, ERROR, false);
+    }
+    else {
+      add_ready(scheduler_global, next_child);
+    }
+    next_child = remove_from_queue(found_barrier->blocked_queue);
+  }
+
+  // take the barrier out of the barrier table and delete it
+  delete_barrier(found_barrier);
+
+  return SUCCESS;
+}
+
+/*
+ * Finds the futex key for the int at addr: the frame it lives in, and its offset in that frame. check_memory loads
+ * the page if it is still in the executable and copies it if it is COW, so the frame is the one our writes land in.
+ */
+static int futex_key(int *addr, unsigned int *key) {
+  if (((unsigned int) addr & (sizeof(int) - 1)) != 0) {
+    TracePrintf(1, "FUTEX: %p isn't int aligned\n", addr);
+    return ERROR;
+  }
+  if (check_memory(addr, sizeof(int), true, true, false, false) == ERROR) {
+    return ERROR;
+  }
+  int page = ((unsigned int) addr - VMEM_1_BASE) >> PAGESHIFT;
+  *key = (running_process->region_1_page_table[page].pfn << PAGESHIFT) | ((unsigned int) addr & PAGEOFFSET);
+  return SUCCESS;
+}
+
+/*
+ * Blocks until a FutexWake on the int at addr, as long as it still holds expected
+ */
+int handle_FutexWait(int *addr, int expected) {
+  unsigned int key;
+  if (futex_key(addr, &key) == ERROR) {
+    TracePrintf(1, "HANDLE_FUTEX_WAIT: Bad futex address %p\n", addr);
+    return ERROR;
+  }
+
+  // the caller saw expected before trapping, but another process may have released the lock since. Nothing else
+  // runs while we're in the kernel, so if the word still holds expected no wake can slip in before we block.
+  if (*addr != expected) {
+    return FUTEX_CHANGED;
+  }
+  futex_t *futex = find_or_create_futex(key);
+  if (futex == NULL) {
+    TracePrintf(1, "HANDLE_FUTEX_WAIT: Unable to create a futex for %p\n", addr);
+    return ERROR;
+  }
+  TracePrintf(1, "HANDLE_FUTEX_WAIT: Process %d waiting on futex %x\n", running_process->pid, key);
+  add_to_queue(futex->waiters, running_process);
+  install_next_from_queue(running_process, 1);
+  return SUCCESS;
+}
+
+/*
+ * Wakes up to num_waiters processes blocked in FutexWait on the int at addr, in the order they blocked
+ */
+int handle_FutexWake(int *addr, int num_waiters) {
+  unsigned int key;
+  if (num_waiters < 0 || futex_key(addr, &key) == ERROR) {
+    TracePrintf(1, "HANDLE_FUTEX_WAKE: Bad futex wake of %d waiters at %p\n", num_waiters, addr);
+    return ERROR;
+  }
+
+  futex_t *futex = find_futex(key);
+  if (futex == NULL) {
+    return 0;
+  }
+  int num_woken = 0;
+  while (num_woken < num_waiters) {
+    pcb_t *next_pcb = remove_from_queue(futex->waiters);
+    if (next_pcb == NULL) {
+      break;
+    }
+    add_ready(scheduler_global, next_pcb);
+    num_woken++;
+  }
+  TracePrintf(1, "HANDLE_FUTEX_WAKE: Woke %d processes waiting on futex %x\n", num_woken, key);
+  // the futex only exists while someone waits on it
+  put_futex(futex);
+  return num_woken;
+}
+
 #endif //CURRENT_CHUNGUS_SYNC_SYSCALL_HANDLERS
\ No newline at end of file
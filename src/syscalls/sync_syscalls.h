@@ -55,11 +55,106 @@ In case of any error, the value ERROR is returned.
  */
 int handle_CvarWait(int cvar_id, int lock_id);
 
+/*
+ * Like CvarWait, but gives up waiting for a signal after ticks clock ticks (at once if ticks is 0). The lock is
+ * re-acquired either way. Returns TIMED_OUT if no signal came in time, and ERROR on any error.
+ */
+int handle_CvarTimedWait(int cvar_id, int lock_id, int ticks);
+
+/*
+ * Like Acquire, but gives up after ticks clock ticks (at once if ticks is 0) and returns TIMED_OUT. In case of any
+ * error, the value ERROR is returned.
+ */
+int handle_AcquireTimeout(int lock_id, int ticks);
+
 /*
  * Kill a cvar with this id
  */
 int handle_CvarKill(int cvar_id, int kill_children);
 
+/*
+ * Create a new semaphore with value units; save its identifier at *sem_idp. In case of any error (including a
+ * negative value), the value ERROR is returned.
+ */
+int handle_SemInit(int *sem_idp, int value);
+
+/*
+ * Give a unit back to the semaphore identified by sem_id. If anyone is blocked in SemDown, the unit goes straight to
+ * the one that has waited longest. In case of any error, the value ERROR is returned.
+ */
+int handle_SemUp(int sem_id);
+
+/*
+ * Take a unit from the semaphore identified by sem_id, blocking until one is available. In case of any error, the
+ * value ERROR is returned.
+ */
+int handle_SemDown(int sem_id);
+
+/*
+ * Kill a semaphore with this id
+ */
+int handle_SemKill(int sem_id, int kill_children);
+
+/*
+ * Create a new reader-writer lock; save its identifier at *rwlock_idp. In case of any error, the value ERROR is
+ * returned.
+ */
+int handle_RwLockInit(int *rwlock_idp);
+
+/*
+ * Acquire the reader-writer lock identified by rwlock_id for reading, alongside any other readers. Waits while a
+ * writer holds the lock or is waiting for it. In case of any error, the value ERROR is returned.
+ */
+int handle_RwAcquireRead(int rwlock_id);
+
+/*
+ * Acquire the reader-writer lock identified by rwlock_id for writing, on our own. In case of any error, the value
+ * ERROR is returned.
+ */
+int handle_RwAcquireWrite(int rwlock_id);
+
+/*
+ * Release the reader-writer lock identified by rwlock_id, whichever way we hold it. In case of any error, the value
+ * ERROR is returned.
+ */
+int handle_RwRelease(int rwlock_id);
+
+/*
+ * Kill a reader-writer lock with this id
+ */
+int handle_RwLockKill(int rwlock_id, int kill_children);
+
+/*
+ * Create a new barrier for num_parties processes; save its identifier at *barrier_idp. In case of any error
+ * (including num_parties < 1), the value ERROR is returned.
+ */
+int handle_BarrierInit(int *barrier_idp, int num_parties);
+
+/*
+ * Wait at the barrier identified by barrier_id until num_parties processes have arrived, then let them all go and
+ * start the next round. In case of any error, the value ERROR is returned.
+ */
+int handle_BarrierWait(int barrier_id);
+
+/*
+ * Kill a barrier with this id
+ */
+int handle_BarrierKill(int barrier_id, int kill_children);
+
+/*
+ * Blocks until a FutexWake on the int at addr, as long as it still holds expected. The word is named by the frame
+ * it lives in and its offset there, so processes sharing the page (see SharePages) wait on the same futex.
+ * returns SUCCESS once woken, FUTEX_CHANGED right away if the word didn't hold expected, or ERROR if addr isn't
+ * an aligned, writable int in user memory
+ */
+int handle_FutexWait(int *addr, int expected);
+
+/*
+ * Wakes up to num_waiters processes blocked in FutexWait on the int at addr
+ * returns the number woken, or ERROR if addr isn't an aligned, writable int in user memory or num_waiters < 0
+ */
+int handle_FutexWake(int *addr, int num_waiters);
+
 
 
 #endif //CURRENT_CHUNGUS_SYNC_SYSCALL_HANDLERS
\ No newline at end of file
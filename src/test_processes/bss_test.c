@@ -0,0 +1,28 @@
+#include <yuser.h>
+
+#define BSS_LEN 1024
+
+// a little initialized data followed by bss, which the linker should put on the same page
+static int data_words[4] = {1, 2, 3, 4};
+static char bss[BSS_LEN];
+
+/*
+ * Checks that bss sharing a page with initialized data comes up zeroed, and that the data next to it is intact
+ */
+int main(void) {
+  int data_page = (int) data_words >> PAGESHIFT;
+  int bss_page = (int) bss >> PAGESHIFT;
+  TracePrintf(1, "BSS_TEST: Data is on page %d, bss starts on page %d%s\n", data_page, bss_page,
+              data_page == bss_page ? "" : " (not the same page; this test proves less)");
+
+  int first_nonzero = -1;
+  for (int i=0; i<BSS_LEN && first_nonzero == -1; i++) {
+    if (bss[i] != 0) {
+      first_nonzero = i;
+    }
+  }
+  TracePrintf(1, "BSS_TEST: The first nonzero bss byte was %d (should be -1)\n", first_nonzero);
+  TracePrintf(1, "BSS_TEST: The data words were %d %d %d %d (should be 1 2 3 4)\n",
+              data_words[0], data_words[1], data_words[2], data_words[3]);
+  Exit(first_nonzero == -1 ? 0 : ERROR);
+}
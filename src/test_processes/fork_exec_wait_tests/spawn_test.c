@@ -0,0 +1,36 @@
+#include <yuser.h>
+#include "../yuser_custom.h"
+
+#define NUM_SPAWNS 20
+
+int main(const int argc, char **argv) {
+  int status;
+
+  // THE FIRST TEST -- SPAWN A PROGRAM WITH ARGUMENTS
+  TracePrintf(1, "SPAWN_TEST: TEST 1\n");
+  char *msg[] = {"test_message", "Hello", "from", "Spawn", NULL};
+  int pid = Spawn("src/test_processes/test_message", msg);
+  TracePrintf(1, "SPAWN_TEST: Spawned pid %d; it should print our four args\n", pid);
+  Wait(&status);
+  TracePrintf(1, "SPAWN_TEST: Child exited with rc=%d (should be 0)\n", status);
+
+  // THE SECOND TEST -- A PROGRAM THAT DOESN'T EXIST FAILS IN THE PARENT, NOT THE CHILD
+  TracePrintf(1, "SPAWN_TEST: TEST 2\n");
+  pid = Spawn("src/test_processes/no_such_program", argv);
+  TracePrintf(1, "SPAWN_TEST: Spawning a missing program returned %d (should be %d)\n", pid, ERROR);
+
+  // THE THIRD TEST -- SPAWN AND REAP MANY CHILDREN; NONE OF OUR PAGES ARE SHARED OR COPIED
+  TracePrintf(1, "SPAWN_TEST: TEST 3\n");
+  for (int i=0; i<NUM_SPAWNS; i++) {
+    pid = Spawn("src/test_processes/exit_test", argv);
+    if (pid == ERROR) {
+      TracePrintf(1, "SPAWN_TEST: Spawn %d failed!\n", i);
+      Exit(-1);
+    }
+    Wait(&status);
+    TracePrintf(1, "SPAWN_TEST: Child %d exited with rc=%d (should be 33)\n", pid, status);
+  }
+
+  TracePrintf(1, "SPAWN_TEST: Done\n");
+  Exit(0);
+}
@@ -0,0 +1,59 @@
+#include <yuser.h>
+#include "../yuser_custom.h"
+
+#define NUM_VFORKS 20
+
+int shared_value = 0;
+
+int main(const int argc, char **argv) {
+  int status;
+
+  // THE FIRST TEST -- THE CHILD RUNS IN OUR MEMORY, AND WE DON'T RUN UNTIL IT EXITS
+  TracePrintf(1, "VFORK_TEST: TEST 1\n");
+  int pid = VFork();
+  if (pid == 0) {
+    shared_value = 58;
+    Exit(7);
+  }
+  TracePrintf(1, "VFORK_TEST: Parent sees shared_value=%d (should be 58)\n", shared_value);
+  Wait(&status);
+  TracePrintf(1, "VFORK_TEST: Child %d exited with rc=%d (should be 7)\n", pid, status);
+
+  // THE SECOND TEST -- THE CHILD EXECS INTO ITS OWN ADDRESS SPACE, AND WE CARRY ON
+  TracePrintf(1, "VFORK_TEST: TEST 2\n");
+  char *msg[] = {"test_message", "Hello", "from", "VFork", NULL};
+  pid = VFork();
+  if (pid == 0) {
+    Exec("src/test_processes/test_message", msg);
+    TracePrintf(1, "VFORK_TEST: Exec failed!\n");
+    Exit(-2);
+  }
+  TracePrintf(1, "VFORK_TEST: Parent back after child %d exec-ed\n", pid);
+  Wait(&status);
+  TracePrintf(1, "VFORK_TEST: Child exited with rc=%d (should be 0)\n", status);
+
+  // THE THIRD TEST -- A FAILED EXEC LEAVES THE CHILD IN OUR MEMORY UNTIL IT EXITS
+  TracePrintf(1, "VFORK_TEST: TEST 3\n");
+  pid = VFork();
+  if (pid == 0) {
+    Exec("src/test_processes/no_such_program", argv);
+    Exit(-2);
+  }
+  Wait(&status);
+  TracePrintf(1, "VFORK_TEST: Child exited with rc=%d (should be -2)\n", status);
+
+  // THE FOURTH TEST -- MANY VFORK/EXECS IN A ROW
+  TracePrintf(1, "VFORK_TEST: TEST 4\n");
+  for (int i=0; i<NUM_VFORKS; i++) {
+    pid = VFork();
+    if (pid == 0) {
+      Exec("src/test_processes/exit_test", argv);
+      Exit(-2);
+    }
+    Wait(&status);
+    TracePrintf(1, "VFORK_TEST: Child %d exited with rc=%d (should be 33)\n", pid, status);
+  }
+
+  TracePrintf(1, "VFORK_TEST: Done\n");
+  Exit(0);
+}
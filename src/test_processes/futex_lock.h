@@ -0,0 +1,54 @@
+/*
+* A lock that lives in user memory, on top of FutexWait/FutexWake. The word is FUTEX_LOCK_FREE, FUTEX_LOCK_HELD, or
+* FUTEX_LOCK_CONTENDED when someone may be asleep waiting for it, and we only trap into the kernel to sleep on a lock
+* someone else holds, or to wake a sleeper when we let go of a contended one. An uncontended acquire and release are
+* one atomic instruction each, where Acquire and Release are a trap each.
+*
+* Processes can share a lock they inherited from a parent that called SharePages on it.
+*/
+#ifndef CURRENT_CHUNGUS_FUTEX_LOCK
+#define CURRENT_CHUNGUS_FUTEX_LOCK
+
+#include "yuser_custom.h"
+
+#define FUTEX_LOCK_FREE 0
+#define FUTEX_LOCK_HELD 1
+#define FUTEX_LOCK_CONTENDED 2
+
+typedef struct futex_lock {
+  volatile int word;
+  volatile int num_kernel_calls;                      // FutexWait and FutexWake calls made for this lock
+} futex_lock_t;
+
+static inline void FutexLockInit(futex_lock_t *lock) {
+  lock->word = FUTEX_LOCK_FREE;
+  lock->num_kernel_calls = 0;
+}
+
+static inline void FutexLockAcquire(futex_lock_t *lock) {
+  int seen = __sync_val_compare_and_swap(&lock->word, FUTEX_LOCK_FREE, FUTEX_LOCK_HELD);
+  if (seen == FUTEX_LOCK_FREE) {
+    return;
+  }
+  // someone has it: mark it contended, so that they wake us, and sleep until we are the one to swap it from free.
+  // Once we have slept we can't tell if others still are, so we take it as contended, and wake someone on release.
+  if (seen != FUTEX_LOCK_CONTENDED) {
+    seen = __sync_lock_test_and_set(&lock->word, FUTEX_LOCK_CONTENDED);
+  }
+  while (seen != FUTEX_LOCK_FREE) {
+    __sync_fetch_and_add(&lock->num_kernel_calls, 1);
+    FutexWait((int *) &lock->word, FUTEX_LOCK_CONTENDED);
+    seen = __sync_lock_test_and_set(&lock->word, FUTEX_LOCK_CONTENDED);
+  }
+}
+
+static inline void FutexLockRelease(futex_lock_t *lock) {
+  if (__sync_fetch_and_sub(&lock->word, 1) != FUTEX_LOCK_HELD) {
+    // it was contended
+    lock->word = FUTEX_LOCK_FREE;
+    __sync_fetch_and_add(&lock->num_kernel_calls, 1);
+    FutexWake((int *) &lock->word, 1);
+  }
+}
+
+#endif //CURRENT_CHUNGUS_FUTEX_LOCK
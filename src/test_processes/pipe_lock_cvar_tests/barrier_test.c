@@ -0,0 +1,76 @@
+#include <yuser.h>
+#include "../yuser_custom.h"
+
+#define NUM_CHILDREN 3
+#define NUM_PARTIES (NUM_CHILDREN + 1)
+#define NUM_PHASES 5
+
+// how many processes have finished each phase; SharePages lets every process see everyone's increments
+static int finished[NUM_PHASES];
+
+/*
+ * Runs the phases, making sure nobody starts a phase before everyone has finished the one before it.
+ * The process with index i spends i ticks on each phase, so the fast ones always have to wait for the slow ones.
+ * returns the number of phases where someone got through the barrier too early
+ */
+static int run_phases(int barrier_id, int index) {
+  int num_early = 0;
+  for (int phase=0; phase<NUM_PHASES; phase++) {
+    if (index > 0) {
+      Delay(index);
+    }
+    __sync_fetch_and_add(&finished[phase], 1);
+    BarrierWait(barrier_id);
+    if (finished[phase] != NUM_PARTIES) {
+      TracePrintf(1, "BARRIER_TEST: Process %d left phase %d when only %d had finished it!\n", GetPid(), phase,
+                  finished[phase]);
+      num_early++;
+    }
+  }
+  return num_early;
+}
+
+int main(void) {
+  int status;
+  int barrier_id;
+
+  // THE FIRST TEST -- BAD ARGUMENTS, AND A BARRIER FOR ONE
+  TracePrintf(1, "BARRIER_TEST: TEST 1\n");
+  TracePrintf(1, "BARRIER_TEST: BarrierInit for 0 returned %d (should be %d)\n", BarrierInit(&barrier_id, 0), ERROR);
+  BarrierInit(&barrier_id, 1);
+  TracePrintf(1, "BARRIER_TEST: Waiting at a barrier for one returned %d (should be 0)\n", BarrierWait(barrier_id));
+  Reclaim(barrier_id);
+  TracePrintf(1, "BARRIER_TEST: Waiting at a reclaimed barrier returned %d (should be %d)\n", BarrierWait(barrier_id),
+              ERROR);
+
+  // THE SECOND TEST -- PHASES
+  TracePrintf(1, "BARRIER_TEST: TEST 2\n");
+  SharePages(finished, sizeof(finished));
+  BarrierInit(&barrier_id, NUM_PARTIES);
+  for (int i=1; i<=NUM_CHILDREN; i++) {
+    if (Fork() == 0) {
+      Exit(run_phases(barrier_id, i));
+    }
+  }
+  int num_early = run_phases(barrier_id, 0);
+  for (int i=0; i<NUM_CHILDREN; i++) {
+    Wait(&status);
+    num_early += status;
+  }
+  TracePrintf(1, "BARRIER_TEST: %d phases were left early (should be 0)\n", num_early);
+
+  // THE THIRD TEST -- RECLAIMING A BARRIER KILLS ITS WAITERS
+  TracePrintf(1, "BARRIER_TEST: TEST 3\n");
+  if (Fork() == 0) {
+    BarrierWait(barrier_id);
+    TracePrintf(1, "BARRIER_TEST: Child should never get here!\n");
+    Exit(0);
+  }
+  Delay(1);
+  Reclaim(barrier_id);
+  Wait(&status);
+  TracePrintf(1, "BARRIER_TEST: The waiter exited with %d (should be %d)\n", status, ERROR);
+
+  TracePrintf(1, "BARRIER_TEST: Done\n");
+  Exit(0);
+}
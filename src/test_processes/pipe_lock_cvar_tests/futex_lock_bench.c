@@ -0,0 +1,87 @@
+#include <yuser.h>
+#include "../futex_lock.h"
+
+#define NUM_ROUNDS 20000                       // acquire/release pairs per process
+#define CRITICAL_SPINS 100                     // work done holding the lock, so that some clock ticks land inside it
+
+// everything parent and child share; SharePages keeps these pages writable in both after Fork
+static struct {
+  futex_lock_t futex_lock;
+  int syscall_lock_id;
+  int counter;
+} shared;
+
+static void critical_section(void) {
+  volatile int spin = 0;
+  while (spin < CRITICAL_SPINS) {
+    spin++;
+  }
+  shared.counter++;
+}
+
+static void syscall_lock_rounds(void) {
+  for (int i=0; i<NUM_ROUNDS; i++) {
+    Acquire(shared.syscall_lock_id);
+    critical_section();
+    Release(shared.syscall_lock_id);
+  }
+}
+
+static void futex_lock_rounds(void) {
+  for (int i=0; i<NUM_ROUNDS; i++) {
+    FutexLockAcquire(&shared.futex_lock);
+    critical_section();
+    FutexLockRelease(&shared.futex_lock);
+  }
+}
+
+/*
+ * Runs rounds in num_procs processes at once (us, plus forked children), and returns the ticks they all took
+ */
+static int time_rounds(void (*rounds)(void), int num_procs) {
+  int status;
+  shared.counter = 0;
+  int start = GetTicks();
+  for (int i=1; i<num_procs; i++) {
+    if (Fork() == 0) {
+      rounds();
+      Exit(0);
+    }
+  }
+  rounds();
+  for (int i=1; i<num_procs; i++) {
+    Wait(&status);
+  }
+  return GetTicks() - start;
+}
+
+/*
+ * Lock ping-pong: the same lock bounces between processes, first with the kernel's Acquire/Release and then with a
+ * futex_lock_t, which only traps when it has to sleep or wake someone. Each test reports the clock ticks it took
+ * and the traps it made, and checks that no increment of the shared counter was lost.
+ */
+int main(void) {
+  if (SharePages(&shared, sizeof(shared)) == ERROR) {
+    TracePrintf(1, "FUTEX_LOCK_BENCH: Unable to share the lock page\n");
+    Exit(ERROR);
+  }
+  LockInit(&shared.syscall_lock_id);
+  FutexLockInit(&shared.futex_lock);
+
+  for (int num_procs=1; num_procs<=2; num_procs++) {
+    TracePrintf(1, "FUTEX_LOCK_BENCH: %d process(es), %d rounds each\n", num_procs, NUM_ROUNDS);
+
+    int ticks = time_rounds(&syscall_lock_rounds, num_procs);
+    TracePrintf(1, "FUTEX_LOCK_BENCH:   syscall lock: %d ticks, %d lock traps, counter %d (should be %d)\n",
+                ticks, 2 * NUM_ROUNDS * num_procs, shared.counter, NUM_ROUNDS * num_procs);
+
+    shared.futex_lock.num_kernel_calls = 0;
+    ticks = time_rounds(&futex_lock_rounds, num_procs);
+    TracePrintf(1, "FUTEX_LOCK_BENCH:   futex lock:   %d ticks, %d lock traps, counter %d (should be %d)\n",
+                ticks, shared.futex_lock.num_kernel_calls, shared.counter, NUM_ROUNDS * num_procs);
+  }
+
+  Reclaim(shared.syscall_lock_id);
+  TracePrintf(1, "FUTEX_LOCK_BENCH: Done\n");
+  Exit(0);
+}
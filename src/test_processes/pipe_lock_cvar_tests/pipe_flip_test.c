@@ -0,0 +1,88 @@
+#include <yuser.h>
+#include "../yuser_custom.h"
+
+#define NUM_PAGES 20                           // more than a pipe holds flipped at once, so the writer has to wait
+
+static char write_space[(NUM_PAGES + 1) * PAGESIZE];
+static char read_space[(NUM_PAGES + 1) * PAGESIZE];
+
+/*
+ * Reads len bytes from the pipe into buf and checks they continue the sequence write_buf was filled with
+ * returns the offset of the first byte that doesn't, or -1 if they all do
+ */
+static int read_and_check(int pipe_id, char *buf, int len, int sequence_start) {
+  int num_read = 0;
+  while (num_read < len) {
+    int rc = PipeRead(pipe_id, buf + num_read, len - num_read);
+    if (rc <= 0) {
+      TracePrintf(1, "PIPE_FLIP_TEST: PipeRead returned %d after %d of %d bytes\n", rc, num_read, len);
+      return num_read;
+    }
+    num_read += rc;
+  }
+  for (int i=0; i<len; i++) {
+    if (buf[i] != (char) (sequence_start + i)) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+int main(void) {
+  int pipe_id;
+  int status;
+  // whole pages of our own, so that writes and reads from them can be flipped
+  char *write_buf = (char *) UP_TO_PAGE(write_space);
+  char *read_buf = (char *) UP_TO_PAGE(read_space);
+  for (int i=0; i<NUM_PAGES * PAGESIZE; i++) {
+    write_buf[i] = (char) i;
+  }
+  PipeInit(&pipe_id);
+
+  // THE FIRST TEST -- AN UNALIGNED WRITE: THE HEAD AND TAIL GO THROUGH THE RING BUFFER, THE PAGES BETWEEN ARE FLIPPED
+  // the pipe must hand back what was written, even though we scribble over the buffer before reading it
+  TracePrintf(1, "PIPE_FLIP_TEST: TEST 1\n");
+  int len = 2 * PAGESIZE + 20;
+  TracePrintf(1, "PIPE_FLIP_TEST: Writing %d bytes returned %d\n", len,
+              PipeWrite(pipe_id, write_buf + PAGESIZE - 10, len));
+  for (int i=0; i<4 * PAGESIZE; i++) {
+    write_buf[i] = 0;
+  }
+  TracePrintf(1, "PIPE_FLIP_TEST: Reading them back page-aligned, the first bad byte was %d (should be -1)\n",
+              read_and_check(pipe_id, read_buf + PAGESIZE - 10, len, PAGESIZE - 10));
+  for (int i=0; i<4 * PAGESIZE; i++) {
+    write_buf[i] = (char) i;
+  }
+
+  // THE SECOND TEST -- A READER THAT ISN'T PAGE-ALIGNED GETS THE FLIPPED PAGES COPIED, IN PIECES
+  TracePrintf(1, "PIPE_FLIP_TEST: TEST 2\n");
+  PipeWrite(pipe_id, write_buf + PAGESIZE - 10, len);
+  int first_bad = -1;
+  for (int num_read=0; num_read<len && first_bad == -1; num_read+=1000) {
+    int chunk = (len - num_read < 1000) ? len - num_read : 1000;
+    first_bad = read_and_check(pipe_id, read_buf + 1, chunk, PAGESIZE - 10 + num_read);
+  }
+  TracePrintf(1, "PIPE_FLIP_TEST: Reading them back 1000 bytes at a time, the first bad byte was %d (should be -1)\n",
+              first_bad);
+
+  // THE THIRD TEST -- A CHILD WRITES MORE PAGES THAN THE PIPE HOLDS WHILE WE READ
+  TracePrintf(1, "PIPE_FLIP_TEST: TEST 3\n");
+  if (Fork() == 0) {
+    int rc = PipeWrite(pipe_id, write_buf, NUM_PAGES * PAGESIZE);
+    Exit(rc == NUM_PAGES * PAGESIZE ? 0 : ERROR);
+  }
+  TracePrintf(1, "PIPE_FLIP_TEST: Reading %d pages, the first bad byte was %d (should be -1)\n", NUM_PAGES,
+              read_and_check(pipe_id, read_buf, NUM_PAGES * PAGESIZE, 0));
+  Wait(&status);
+  TracePrintf(1, "PIPE_FLIP_TEST: The writer exited with %d (should be 0)\n", status);
+
+  // THE FOURTH TEST -- RECLAIMING A PIPE THAT STILL HOLDS FLIPPED PAGES GIVES THEM BACK
+  TracePrintf(1, "PIPE_FLIP_TEST: TEST 4\n");
+  PipeWrite(pipe_id, write_buf, 2 * PAGESIZE);
+  TracePrintf(1, "PIPE_FLIP_TEST: Reclaiming the pipe returned %d (should be 0)\n", Reclaim(pipe_id));
+  write_buf[0] = 1;
+  TracePrintf(1, "PIPE_FLIP_TEST: Wrote to a page the pipe had held\n");
+
+  TracePrintf(1, "PIPE_FLIP_TEST: Done\n");
+  Exit(0);
+}
@@ -0,0 +1,79 @@
+#include <yuser.h>
+#include "../yuser_custom.h"
+
+#define SMALL_PAGES 2
+#define SMALL_WRITE 3000                       // less than a page, so these writes go through the ring buffer
+
+static char write_buf[PIPE_MAX_CAPACITY];
+static char read_buf[PIPE_MAX_CAPACITY];
+
+/*
+ * Reads len bytes from the pipe and checks they continue the sequence write_buf was filled with
+ * returns the offset of the first byte that doesn't, or -1 if they all do
+ */
+static int read_and_check(int pipe_id, int len, int sequence_start) {
+  int num_read = PipeRead(pipe_id, read_buf, len);
+  if (num_read != len) {
+    TracePrintf(1, "PIPE_SIZED_TEST: Read %d bytes instead of %d\n", num_read, len);
+    return 0;
+  }
+  for (int i=0; i<len; i++) {
+    if (read_buf[i] != (char) (sequence_start + i)) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+int main(void) {
+  int pipe_id;
+  int small = SMALL_PAGES * PAGESIZE;
+  for (int i=0; i<PIPE_MAX_CAPACITY; i++) {
+    write_buf[i] = (char) i;
+  }
+
+  // THE FIRST TEST -- BAD SIZES
+  TracePrintf(1, "PIPE_SIZED_TEST: TEST 1\n");
+  TracePrintf(1, "PIPE_SIZED_TEST: PipeInitSized of 0 returned %d (should be %d)\n", PipeInitSized(&pipe_id, 0), ERROR);
+  TracePrintf(1, "PIPE_SIZED_TEST: PipeInitSized of %d returned %d (should be %d)\n", PIPE_MAX_CAPACITY + 1,
+              PipeInitSized(&pipe_id, PIPE_MAX_CAPACITY + 1), ERROR);
+
+  // THE SECOND TEST -- A SIZED PIPE TAKES A WRITE OF ITS WHOLE CAPACITY WITHOUT BLOCKING
+  // (we are the only reader, so blocking here would hang the test)
+  TracePrintf(1, "PIPE_SIZED_TEST: TEST 2\n");
+  PipeInitSized(&pipe_id, small - 100);
+  TracePrintf(1, "PIPE_SIZED_TEST: Writing %d bytes returned %d\n", small, PipeWrite(pipe_id, write_buf, small));
+  TracePrintf(1, "PIPE_SIZED_TEST: Reading them back, the first bad byte was %d (should be -1)\n",
+              read_and_check(pipe_id, small, 0));
+
+  // THE THIRD TEST -- RESIZING KEEPS WHAT IS IN THE PIPE, EVEN WHEN IT WRAPS AROUND THE BUFFER
+  TracePrintf(1, "PIPE_SIZED_TEST: TEST 3\n");
+  PipeWrite(pipe_id, write_buf, small - 10);
+  read_and_check(pipe_id, small - 20, 0);
+  // the 10 unread bytes are at the end of the buffer; these 20 wrap around to its front
+  PipeWrite(pipe_id, write_buf + small - 10, 20);
+  TracePrintf(1, "PIPE_SIZED_TEST: Growing to %d bytes returned %d (should be 0)\n", PIPE_MAX_CAPACITY,
+              PipeResize(pipe_id, PIPE_MAX_CAPACITY));
+  TracePrintf(1, "PIPE_SIZED_TEST: After growing, the first bad byte was %d (should be -1)\n",
+              read_and_check(pipe_id, 30, small - 20));
+  TracePrintf(1, "PIPE_SIZED_TEST: Writing %d bytes returned %d\n", PIPE_MAX_CAPACITY,
+              PipeWrite(pipe_id, write_buf, PIPE_MAX_CAPACITY));
+  TracePrintf(1, "PIPE_SIZED_TEST: Reading them back, the first bad byte was %d (should be -1)\n",
+              read_and_check(pipe_id, PIPE_MAX_CAPACITY, 0));
+
+  // THE FOURTH TEST -- A PIPE WON'T SHRINK BELOW WHAT IT HOLDS
+  TracePrintf(1, "PIPE_SIZED_TEST: TEST 4\n");
+  for (int i=0; i<3; i++) {
+    PipeWrite(pipe_id, write_buf + i * SMALL_WRITE, SMALL_WRITE);
+  }
+  TracePrintf(1, "PIPE_SIZED_TEST: Shrinking below the %d unread bytes to 1 byte (one page) returned %d "
+              "(should be %d)\n", 3 * SMALL_WRITE, PipeResize(pipe_id, 1), ERROR);
+  TracePrintf(1, "PIPE_SIZED_TEST: After the failed shrink, the first bad byte was %d (should be -1)\n",
+              read_and_check(pipe_id, 3 * SMALL_WRITE, 0));
+  TracePrintf(1, "PIPE_SIZED_TEST: Shrinking the empty pipe to 1 byte (one page) returned %d (should be 0)\n",
+              PipeResize(pipe_id, 1));
+
+  Reclaim(pipe_id);
+  TracePrintf(1, "PIPE_SIZED_TEST: Done\n");
+  Exit(0);
+}
@@ -0,0 +1,68 @@
+#include <yuser.h>
+#include "../yuser_custom.h"
+
+#define TOTAL_BYTES (1 << 20)                  // bytes pushed through the pipe at each write size
+#define MAX_WRITE_SIZE (4 * PAGESIZE)
+
+static const int write_sizes[] = {1, 16, 64, 256, 1024, PAGESIZE, MAX_WRITE_SIZE};
+static char buf_space[MAX_WRITE_SIZE + PAGESIZE];
+static char *buf;                              // page-aligned, so whole-page writes are flipped rather than copied
+
+/*
+ * Pushes TOTAL_BYTES through the pipe at each write size, with a child reading while we write, and reports bytes
+ * per clock tick. The reader uses the same chunk size, so small sizes show the per-call overhead and large ones the
+ * copying, plus the block/wake round trips each time the pipe buffer fills.
+ */
+static void run_write_sizes(int pipe_id, char *pipe_name) {
+  int status;
+  int num_sizes = sizeof(write_sizes) / sizeof(write_sizes[0]);
+  for (int i=0; i<num_sizes; i++) {
+    int size = write_sizes[i];
+    int start = GetTicks();
+
+    if (Fork() == 0) {
+      int num_read = 0;
+      while (num_read < TOTAL_BYTES) {
+        int rc = PipeRead(pipe_id, buf, size);
+        if (rc <= 0) {
+          Exit(ERROR);
+        }
+        num_read += rc;
+      }
+      Exit(0);
+    }
+    for (int num_written=0; num_written<TOTAL_BYTES; num_written+=size) {
+      PipeWrite(pipe_id, buf, size);
+    }
+    Wait(&status);
+
+    int ticks = GetTicks() - start;
+    TracePrintf(1, "PIPE_THROUGHPUT_BENCH: %s, %5d byte writes: %d bytes in %d ticks, %d bytes/tick%s\n", pipe_name,
+                size, TOTAL_BYTES, ticks, ticks > 0 ? TOTAL_BYTES / ticks : TOTAL_BYTES,
+                status == 0 ? "" : " (reader failed!)");
+  }
+}
+
+/*
+ * Pipe throughput, first through a PipeInit pipe and then through one of PIPE_MAX_CAPACITY bytes
+ */
+int main(void) {
+  int pipe_id;
+  int sized_pipe_id;
+  if (PipeInit(&pipe_id) == ERROR || PipeInitSized(&sized_pipe_id, PIPE_MAX_CAPACITY) == ERROR) {
+    TracePrintf(1, "PIPE_THROUGHPUT_BENCH: Unable to create the pipes\n");
+    Exit(ERROR);
+  }
+  buf = (char *) UP_TO_PAGE(buf_space);
+  for (int i=0; i<MAX_WRITE_SIZE; i++) {
+    buf[i] = (char) i;
+  }
+
+  run_write_sizes(pipe_id, "default pipe");
+  run_write_sizes(sized_pipe_id, "sized pipe");
+
+  Reclaim(pipe_id);
+  Reclaim(sized_pipe_id);
+  TracePrintf(1, "PIPE_THROUGHPUT_BENCH: Done\n");
+  Exit(0);
+}
@@ -0,0 +1,85 @@
+#include <yuser.h>
+#include "../yuser_custom.h"
+
+#define NUM_READERS 3
+#define WRITER_RC 10
+#define LATE_READER_RC 11
+
+int main(void) {
+  int status;
+  int rwlock_id;
+  RwLockInit(&rwlock_id);
+
+  // THE FIRST TEST -- READERS DON'T WAIT FOR EACH OTHER
+  TracePrintf(1, "RWLOCK_TEST: TEST 1\n");
+  RwAcquireRead(rwlock_id);
+  for (int i=0; i<NUM_READERS; i++) {
+    if (Fork() == 0) {
+      RwAcquireRead(rwlock_id);
+      RwRelease(rwlock_id);
+      Exit(i);
+    }
+  }
+  // if readers excluded each other, these would never return while we hold the lock
+  for (int i=0; i<NUM_READERS; i++) {
+    Wait(&status);
+    TracePrintf(1, "RWLOCK_TEST: Reader %d got in alongside us\n", status);
+  }
+
+  // THE SECOND TEST -- A WAITING WRITER KEEPS NEW READERS OUT
+  TracePrintf(1, "RWLOCK_TEST: TEST 2\n");
+  if (Fork() == 0) {
+    RwAcquireWrite(rwlock_id);
+    Delay(2);
+    RwRelease(rwlock_id);
+    Exit(WRITER_RC);
+  }
+  Delay(1);
+  if (Fork() == 0) {
+    RwAcquireRead(rwlock_id);
+    RwRelease(rwlock_id);
+    Exit(LATE_READER_RC);
+  }
+  Delay(1);
+  RwRelease(rwlock_id);
+  Wait(&status);
+  TracePrintf(1, "RWLOCK_TEST: First to finish was %d (should be the writer, %d)\n", status, WRITER_RC);
+  Wait(&status);
+  TracePrintf(1, "RWLOCK_TEST: Second to finish was %d (should be the late reader, %d)\n", status, LATE_READER_RC);
+
+  // THE THIRD TEST -- READERS WAITING ON A WRITER ARE LET IN TOGETHER
+  TracePrintf(1, "RWLOCK_TEST: TEST 3\n");
+  RwAcquireWrite(rwlock_id);
+  for (int i=0; i<NUM_READERS; i++) {
+    if (Fork() == 0) {
+      RwAcquireRead(rwlock_id);
+      // hold the lock for a while; the other readers should be holding it too
+      Delay(2);
+      RwRelease(rwlock_id);
+      Exit(i);
+    }
+  }
+  Delay(1);
+  RwRelease(rwlock_id);
+  for (int i=0; i<NUM_READERS; i++) {
+    Wait(&status);
+  }
+  TracePrintf(1, "RWLOCK_TEST: Readers all done; RwRelease with nothing held returned %d (should be %d)\n",
+              RwRelease(rwlock_id), ERROR);
+
+  // THE FOURTH TEST -- RECLAIMING THE LOCK KILLS ITS WAITERS
+  TracePrintf(1, "RWLOCK_TEST: TEST 4\n");
+  RwAcquireWrite(rwlock_id);
+  if (Fork() == 0) {
+    RwAcquireRead(rwlock_id);
+    TracePrintf(1, "RWLOCK_TEST: Child should never get here!\n");
+    Exit(0);
+  }
+  Delay(1);
+  Reclaim(rwlock_id);
+  Wait(&status);
+  TracePrintf(1, "RWLOCK_TEST: The waiter exited with %d (should be %d)\n", status, ERROR);
+
+  TracePrintf(1, "RWLOCK_TEST: Done\n");
+  Exit(0);
+}
@@ -0,0 +1,51 @@
+#include <yuser.h>
+
+#define NUM_WAITERS 3
+
+int main(void) {
+  int status;
+  int sem_id;
+
+  // THE FIRST TEST -- BAD ARGUMENTS, AND DOWNS THAT DON'T BLOCK
+  TracePrintf(1, "SEM_TEST: TEST 1\n");
+  TracePrintf(1, "SEM_TEST: SemInit with value -1 returned %d (should be %d)\n", SemInit(&sem_id, -1), ERROR);
+  SemInit(&sem_id, 2);
+  TracePrintf(1, "SEM_TEST: Two downs on a semaphore of 2 returned %d and %d (should be 0 and 0)\n",
+              SemDown(sem_id), SemDown(sem_id));
+  SemUp(sem_id);
+  SemUp(sem_id);
+  Reclaim(sem_id);
+  TracePrintf(1, "SEM_TEST: SemUp on a reclaimed semaphore returned %d (should be %d)\n", SemUp(sem_id), ERROR);
+
+  // THE SECOND TEST -- WAITERS GET UNITS IN THE ORDER THEY BLOCKED
+  TracePrintf(1, "SEM_TEST: TEST 2\n");
+  SemInit(&sem_id, 0);
+  for (int i=0; i<NUM_WAITERS; i++) {
+    if (Fork() == 0) {
+      SemDown(sem_id);
+      Exit(i);
+    }
+    // let the child block before forking the next one
+    Delay(1);
+  }
+  for (int i=0; i<NUM_WAITERS; i++) {
+    SemUp(sem_id);
+    Wait(&status);
+    TracePrintf(1, "SEM_TEST: Up number %d woke waiter %d (should be %d)\n", i, status, i);
+  }
+
+  // THE THIRD TEST -- RECLAIMING A SEMAPHORE KILLS ITS WAITERS
+  TracePrintf(1, "SEM_TEST: TEST 3\n");
+  if (Fork() == 0) {
+    SemDown(sem_id);
+    TracePrintf(1, "SEM_TEST: Child should never get here!\n");
+    Exit(0);
+  }
+  Delay(2);
+  Reclaim(sem_id);
+  Wait(&status);
+  TracePrintf(1, "SEM_TEST: The waiter exited with %d (should be %d)\n", status, ERROR);
+
+  TracePrintf(1, "SEM_TEST: Done\n");
+  Exit(0);
+}
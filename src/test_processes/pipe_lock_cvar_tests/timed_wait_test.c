@@ -0,0 +1,57 @@
+#include <yuser.h>
+#include "../yuser_custom.h"
+
+#define HOLD_TICKS 5
+
+int main(void) {
+  int status;
+  int lock_id;
+  int cvar_id;
+  LockInit(&lock_id);
+  CvarInit(&cvar_id);
+
+  // THE FIRST TEST -- ACQUIRE TIMEOUTS ON A LOCK A CHILD HOLDS FOR A WHILE
+  TracePrintf(1, "TIMED_WAIT_TEST: TEST 1\n");
+  if (Fork() == 0) {
+    Acquire(lock_id);
+    Delay(HOLD_TICKS);
+    Release(lock_id);
+    Exit(0);
+  }
+  Delay(1);
+  TracePrintf(1, "TIMED_WAIT_TEST: AcquireTimeout of 0 ticks returned %d (should be %d)\n",
+              AcquireTimeout(lock_id, 0), TIMED_OUT);
+  int start = GetTicks();
+  int rc = AcquireTimeout(lock_id, 2);
+  TracePrintf(1, "TIMED_WAIT_TEST: AcquireTimeout of 2 ticks returned %d (should be %d) after %d ticks\n",
+              rc, TIMED_OUT, GetTicks() - start);
+  rc = AcquireTimeout(lock_id, 2 * HOLD_TICKS);
+  TracePrintf(1, "TIMED_WAIT_TEST: AcquireTimeout of %d ticks returned %d (should be 0)\n", 2 * HOLD_TICKS, rc);
+  Wait(&status);
+
+  // THE SECOND TEST -- NOBODY SIGNALS, SO THE WAIT TIMES OUT, AND WE STILL GET THE LOCK BACK
+  TracePrintf(1, "TIMED_WAIT_TEST: TEST 2\n");
+  start = GetTicks();
+  rc = CvarTimedWait(cvar_id, lock_id, 3);
+  TracePrintf(1, "TIMED_WAIT_TEST: CvarTimedWait of 3 ticks returned %d (should be %d) after %d ticks\n",
+              rc, TIMED_OUT, GetTicks() - start);
+  TracePrintf(1, "TIMED_WAIT_TEST: Releasing the lock returned %d (should be 0)\n", Release(lock_id));
+
+  // THE THIRD TEST -- A CHILD SIGNALS BEFORE THE TIMEOUT
+  TracePrintf(1, "TIMED_WAIT_TEST: TEST 3\n");
+  if (Fork() == 0) {
+    Delay(2);
+    Acquire(lock_id);
+    CvarSignal(cvar_id);
+    Release(lock_id);
+    Exit(0);
+  }
+  Acquire(lock_id);
+  rc = CvarTimedWait(cvar_id, lock_id, 100);
+  TracePrintf(1, "TIMED_WAIT_TEST: Signaled CvarTimedWait returned %d (should be 0)\n", rc);
+  Release(lock_id);
+  Wait(&status);
+
+  TracePrintf(1, "TIMED_WAIT_TEST: Done\n");
+  Exit(0);
+}
@@ -0,0 +1,94 @@
+#include <yuser.h>
+#include "yuser_custom.h"
+
+#define BATCH_SPINS 100000000
+#define SHARE_TICKS 20
+
+// how far each spinner in the fourth test got; SharePages lets the parent see the children's counts
+static struct {
+  volatile int spins[2];
+  volatile int stop;
+} share;
+
+/*
+ * Spins at this priority, counting in share.spins[index], until the parent says stop
+ */
+static void spin_at_priority(int priority, int index) {
+  SetPriority(GetPid(), priority);
+  while (!share.stop) {
+    share.spins[index]++;
+  }
+  Exit(0);
+}
+
+int main(void) {
+  int status;
+  int pid = GetPid();
+
+  // THE FIRST TEST -- OUR OWN PRIORITY, AND BAD REQUESTS
+  TracePrintf(1, "PRIORITY_TEST: TEST 1\n");
+  TracePrintf(1, "PRIORITY_TEST: Our priority is %d (should be %d)\n", GetPriority(pid), PRIORITY_DEFAULT);
+  TracePrintf(1, "PRIORITY_TEST: Priority %d returned %d (should be %d)\n", PRIORITY_LOWEST + 1,
+              SetPriority(pid, PRIORITY_LOWEST + 1), ERROR);
+  TracePrintf(1, "PRIORITY_TEST: Priority -1 returned %d (should be %d)\n", SetPriority(pid, -1), ERROR);
+  TracePrintf(1, "PRIORITY_TEST: Pid %d (not ours) returned %d (should be %d)\n", pid + 1000,
+              GetPriority(pid + 1000), ERROR);
+  SetPriority(pid, 3);
+  TracePrintf(1, "PRIORITY_TEST: Our priority is now %d (should be 3)\n", GetPriority(pid));
+
+  // THE SECOND TEST -- CHILDREN INHERIT OUR PRIORITY, AND WE CAN CHANGE THEIRS
+  TracePrintf(1, "PRIORITY_TEST: TEST 2\n");
+  int child = Fork();
+  if (child == 0) {
+    TracePrintf(1, "PRIORITY_TEST: Child starts with priority %d (should be 3)\n", GetPriority(GetPid()));
+    Delay(2);
+    TracePrintf(1, "PRIORITY_TEST: Child now has priority %d (should be %d)\n", GetPriority(GetPid()), PRIORITY_LOWEST);
+    Exit(0);
+  }
+  SetPriority(child, PRIORITY_LOWEST);
+  TracePrintf(1, "PRIORITY_TEST: We see the child's priority as %d (should be %d)\n", GetPriority(child), PRIORITY_LOWEST);
+  Wait(&status);
+  TracePrintf(1, "PRIORITY_TEST: The exited child's priority lookup returned %d (should be %d)\n",
+              GetPriority(child), ERROR);
+
+  // THE THIRD TEST -- A BATCH JOB AND AN INTERACTIVE ONE; THE BATCH JOB RUNS PRIORITY_LOWEST + 1 TICKS PER TURN,
+  // BUT RARELY, SO THE INTERACTIVE ROUNDS SELDOM WAIT BEHIND IT
+  TracePrintf(1, "PRIORITY_TEST: TEST 3\n");
+  SetPriority(pid, PRIORITY_DEFAULT);
+  child = Fork();
+  if (child == 0) {
+    SetPriority(GetPid(), PRIORITY_LOWEST);
+    volatile int spin = 0;
+    while (spin < BATCH_SPINS) {
+      spin++;
+    }
+    TracePrintf(1, "PRIORITY_TEST: Batch child is done\n");
+    Exit(0);
+  }
+  for (int round=0; round<10; round++) {
+    Delay(1);
+    TracePrintf(1, "PRIORITY_TEST: Interactive round %d\n", round);
+  }
+  Wait(&status);
+
+  // THE FOURTH TEST -- TWO SPINNERS: THE PRIORITY 0 ONE GETS MORE OF THE CPU THAN THE PRIORITY_LOWEST ONE
+  TracePrintf(1, "PRIORITY_TEST: TEST 4\n");
+  SharePages((void *) &share, sizeof(share));
+  if (Fork() == 0) {
+    spin_at_priority(PRIORITY_HIGHEST, 0);
+  }
+  if (Fork() == 0) {
+    spin_at_priority(PRIORITY_LOWEST, 1);
+  }
+  Delay(SHARE_TICKS);
+  share.stop = 1;
+  Wait(&status);
+  Wait(&status);
+  TracePrintf(1, "PRIORITY_TEST: Priority %d spun %d times, priority %d spun %d times\n", PRIORITY_HIGHEST,
+              share.spins[0], PRIORITY_LOWEST, share.spins[1]);
+  TracePrintf(1, "PRIORITY_TEST: The priority %d spinner got more CPU: %s (should be yes)\n", PRIORITY_HIGHEST,
+              share.spins[0] > share.spins[1] ? "yes" : "no");
+
+  TracePrintf(1, "PRIORITY_TEST: Done\n");
+  Exit(0);
+}
@@ -0,0 +1,45 @@
+#include <yuser.h>
+
+#define NUM_HOGS 3
+#define HOG_SPINS 200000000                    // several clock ticks of pure computation per hog
+#define NUM_ROUNDS 20                          // Delay(1) rounds for the interactive child
+#define INTERACTIVE_RC 1
+#define HOG_RC 2
+
+/*
+ * Runs CPU hogs alongside an interactive child that keeps blocking in Delay, and reports the order they finish in.
+ * Boot with sched=mlfq and sched=rr to compare: under MLFQ the interactive child should get back on the CPU right
+ * after each Delay, rather than waiting behind every hog. The kernel traces the clock and scheduler stats at level 3
+ * as each child exits.
+ */
+int main(void) {
+  int status;
+
+  for (int i=0; i<NUM_HOGS; i++) {
+    if (Fork() == 0) {
+      volatile int spin = 0;
+      while (spin < HOG_SPINS) {
+        spin++;
+      }
+      TracePrintf(1, "SCHEDULER_TEST: Hog %d is done\n", GetPid());
+      Exit(HOG_RC);
+    }
+  }
+
+  if (Fork() == 0) {
+    for (int round=0; round<NUM_ROUNDS; round++) {
+      Delay(1);
+      TracePrintf(1, "SCHEDULER_TEST: Interactive child %d finished round %d\n", GetPid(), round);
+    }
+    Exit(INTERACTIVE_RC);
+  }
+
+  for (int i=0; i<NUM_HOGS + 1; i++) {
+    int pid = Wait(&status);
+    TracePrintf(1, "SCHEDULER_TEST: Child %d (%s) finished in position %d\n", pid,
+                status == INTERACTIVE_RC ? "interactive" : "hog", i + 1);
+  }
+
+  TracePrintf(1, "SCHEDULER_TEST: Done\n");
+  Exit(0);
+}
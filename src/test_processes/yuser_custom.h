@@ -0,0 +1,161 @@
+/*
+* User-side wrappers for our own syscalls. Each one traps through Custom0, with the call
+* number from syscalls/custom_syscalls.h first; see handle_trap_custom in trap_handlers.c.
+*/
+#ifndef CURRENT_CHUNGUS_YUSER_CUSTOM
+#define CURRENT_CHUNGUS_YUSER_CUSTOM
+
+#include <yuser.h>
+#include "../syscalls/custom_syscalls.h"
+
+/*
+* Start a new process running file with arguments argvec, without copying our address space.
+* returns the child's pid, or ERROR if file can't be loaded
+*/
+static inline int Spawn(char *file, char **argvec) {
+  return Custom0(CUSTOM_SPAWN, (int) file, (int) argvec, 0);
+}
+
+/*
+* Fork without copying our address space. The child runs in our memory (on our stack!) and we are
+* blocked until it calls Exec or Exit, so the child should do nothing else.
+* returns 0 in the child and the child's pid in the parent, or ERROR
+*/
+static inline int VFork(void) {
+  return Custom0(CUSTOM_VFORK, 0, 0, 0);
+}
+
+/*
+* Set the priority (PRIORITY_HIGHEST..PRIORITY_LOWEST) of ourselves or one of our children. A process at priority p
+* runs p + 1 ticks per turn, so batch jobs are switched out less often, but gets (p + 1)^2 times fewer turns, so
+* they get less of the CPU overall.
+* returns 0, or ERROR if pid isn't us or a live child, or the priority is out of range
+*/
+static inline int SetPriority(int pid, int priority) {
+  return Custom0(CUSTOM_SET_PRIORITY, pid, priority, 0);
+}
+
+/*
+* returns the priority of ourselves or one of our children, or ERROR if pid isn't us or a live child
+*/
+static inline int GetPriority(int pid) {
+  return Custom0(CUSTOM_GET_PRIORITY, pid, 0, 0);
+}
+
+/*
+* Share the pages holding [addr, addr+len) with the children we fork from now on: they map the same memory
+* writable rather than getting copy-on-write copies, so we see each other's writes. Use it on globals or heap.
+* returns 0, or ERROR if the range isn't writable memory of ours
+*/
+static inline int SharePages(void *addr, int len) {
+  return Custom0(CUSTOM_SHARE_PAGES, (int) addr, len, 0);
+}
+
+/*
+* Sleep until a FutexWake on *addr, unless *addr no longer holds expected. See futex_lock.h for a lock built on it.
+* returns 0 once woken, FUTEX_CHANGED if *addr didn't hold expected, or ERROR if addr isn't an aligned int of ours
+*/
+static inline int FutexWait(int *addr, int expected) {
+  return Custom0(CUSTOM_FUTEX_WAIT, (int) addr, expected, 0);
+}
+
+/*
+* Wake up to num_waiters processes sleeping in FutexWait on *addr
+* returns the number woken, or ERROR
+*/
+static inline int FutexWake(int *addr, int num_waiters) {
+  return Custom0(CUSTOM_FUTEX_WAKE, (int) addr, num_waiters, 0);
+}
+
+/*
+* returns the number of clock ticks since boot
+*/
+static inline int GetTicks(void) {
+  return Custom0(CUSTOM_GET_TICKS, 0, 0, 0);
+}
+
+/*
+* Create a reader-writer lock, saving its id (which Reclaim takes) at *rwlock_idp
+* returns 0, or ERROR
+*/
+static inline int RwLockInit(int *rwlock_idp) {
+  return Custom0(CUSTOM_RWLOCK_INIT, (int) rwlock_idp, 0, 0);
+}
+
+/*
+* Hold the lock for reading, alongside any other readers. Writers come first: we wait while one holds the lock or
+* is waiting for it.
+* returns 0, or ERROR
+*/
+static inline int RwAcquireRead(int rwlock_id) {
+  return Custom0(CUSTOM_RW_ACQUIRE_READ, rwlock_id, 0, 0);
+}
+
+/*
+* Hold the lock for writing, with no readers or other writers
+* returns 0, or ERROR
+*/
+static inline int RwAcquireWrite(int rwlock_id) {
+  return Custom0(CUSTOM_RW_ACQUIRE_WRITE, rwlock_id, 0, 0);
+}
+
+/*
+* Let go of the lock, whether we hold it for reading or writing
+* returns 0, or ERROR if we don't hold it
+*/
+static inline int RwRelease(int rwlock_id) {
+  return Custom0(CUSTOM_RW_RELEASE, rwlock_id, 0, 0);
+}
+
+/*
+* Create a barrier for num_parties processes, saving its id (which Reclaim takes) at *barrier_idp
+* returns 0, or ERROR
+*/
+static inline int BarrierInit(int *barrier_idp, int num_parties) {
+  return Custom0(CUSTOM_BARRIER_INIT, (int) barrier_idp, num_parties, 0);
+}
+
+/*
+* Wait until num_parties processes (us included) are waiting at the barrier, then all go on together. The barrier
+* can be used again straight away for the next phase.
+* returns 0, or ERROR
+*/
+static inline int BarrierWait(int barrier_id) {
+  return Custom0(CUSTOM_BARRIER_WAIT, barrier_id, 0, 0);
+}
+
+/*
+* Like CvarWait, but stop waiting for a signal after ticks clock ticks (at once if ticks is 0). We hold the lock
+* again when it returns either way.
+* returns 0 if signaled, TIMED_OUT if not, or ERROR
+*/
+static inline int CvarTimedWait(int cvar_id, int lock_id, int ticks) {
+  return Custom0(CUSTOM_CVAR_TIMED_WAIT, cvar_id, lock_id, ticks);
+}
+
+/*
+* Like Acquire, but give up after ticks clock ticks (at once if ticks is 0)
+* returns 0 once we hold the lock, TIMED_OUT if it didn't come free in time, or ERROR
+*/
+static inline int AcquireTimeout(int lock_id, int ticks) {
+  return Custom0(CUSTOM_ACQUIRE_TIMEOUT, lock_id, ticks, 0);
+}
+
+/*
+* Create a pipe holding capacity bytes (up to PIPE_MAX_CAPACITY, rounded up to whole pages), where PipeInit pipes
+* hold PIPE_BUFFER_LEN. A bigger pipe means a writer blocks less often. Saves its id at *pipe_idp.
+* returns 0, or ERROR
+*/
+static inline int PipeInitSized(int *pipe_idp, int capacity) {
+  return Custom0(CUSTOM_PIPE_INIT_SIZED, (int) pipe_idp, capacity, 0);
+}
+
+/*
+* Change how much a pipe holds (up to PIPE_MAX_CAPACITY, rounded up to whole pages). Unread bytes are kept.
+* returns 0, or ERROR if capacity is out of range or less than the pipe holds right now
+*/
+static inline int PipeResize(int pipe_id, int capacity) {
+  return Custom0(CUSTOM_PIPE_RESIZE, pipe_id, capacity, 0);
+}
+
+#endif //CURRENT_CHUNGUS_YUSER_CUSTOM
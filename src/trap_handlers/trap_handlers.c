@@ -1,5 +1,6 @@
 #include <ykernel.h>
 #include <hardware.h>
+#include <time.h>
 #include "../kernel_start.h"
 #include "../kernel_utils.h"
 #include "trap_handlers.h"
@@ -8,13 +9,95 @@
 #include "../syscalls/ipc_syscalls.h"
 #include "../syscalls/process_syscalls.h"
 #include "../syscalls/sync_syscalls.h"
+#include "../syscalls/custom_syscalls.h"
 #include "../data_structures/queue.h"
 #include "../debug_utils/debug.h"
 #include "../data_structures/tty.h"
+#include "../memory/cow.h"
+#include "../memory/demand_paging.h"
 
 // the number of pages away from the user stack we can be and still allow the stack to expand
 int PAGES_AWAY_FROM_USER_STACK = 2;
 
+clock_stats_t clock_stats;
+
+// the clock trap that is switching processes, until the process it switches to resumes in handle_trap_clock
+static bool clock_switch_pending = false;
+static long long clock_switch_start_ns;
+static unsigned int clock_switch_tick;
+static bool clock_switch_idle;
+
+/*
+ * Handle our own syscalls, which all come in through YALNIX_CUSTOM_0 with the call number in regs[0]
+ * (see syscalls/custom_syscalls.h)
+ */
+static int handle_trap_custom(UserContext* context) {
+  int rc = ERROR;
+  switch (context->regs[0]) {
+    case CUSTOM_SPAWN:
+      // like exec, the child starts from (and returns into) a copy of our user context
+      memcpy(running_process->uctxt, context, sizeof(UserContext));
+      rc = handle_Spawn((char *)context->regs[1], (char **) context->regs[2]);
+      memcpy(context, running_process->uctxt, sizeof(UserContext));
+      break;
+    case CUSTOM_VFORK:
+      rc = handle_VFork();
+      break;
+    case CUSTOM_SET_PRIORITY:
+      rc = handle_SetPriority(context->regs[1], context->regs[2]);
+      break;
+    case CUSTOM_GET_PRIORITY:
+      rc = handle_GetPriority(context->regs[1]);
+      break;
+    case CUSTOM_SHARE_PAGES:
+      rc = handle_SharePages((void *) context->regs[1], context->regs[2]);
+      break;
+    case CUSTOM_FUTEX_WAIT:
+      rc = handle_FutexWait((int *) context->regs[1], context->regs[2]);
+      break;
+    case CUSTOM_FUTEX_WAKE:
+      rc = handle_FutexWake((int *) context->regs[1], context->regs[2]);
+      break;
+    case CUSTOM_GET_TICKS:
+      rc = handle_GetTicks();
+      break;
+    case CUSTOM_RWLOCK_INIT:
+      rc = handle_RwLockInit((int *) context->regs[1]);
+      break;
+    case CUSTOM_RW_ACQUIRE_READ:
+      rc = handle_RwAcquireRead(context->regs[1]);
+      break;
+    case CUSTOM_RW_ACQUIRE_WRITE:
+      rc = handle_RwAcquireWrite(context->regs[1]);
+      break;
+    case CUSTOM_RW_RELEASE:
+      rc = handle_RwRelease(context->regs[1]);
+      break;
+    case CUSTOM_BARRIER_INIT:
+      rc = handle_BarrierInit((int *) context->regs[1], context->regs[2]);
+      break;
+    case CUSTOM_BARRIER_WAIT:
+      rc = handle_BarrierWait(context->regs[1]);
+      break;
+    case CUSTOM_CVAR_TIMED_WAIT:
+      rc = handle_CvarTimedWait(context->regs[1], context->regs[2], context->regs[3]);
+      break;
+    case CUSTOM_ACQUIRE_TIMEOUT:
+      rc = handle_AcquireTimeout(context->regs[1], context->regs[2]);
+      break;
+    case CUSTOM_PIPE_INIT_SIZED:
+      rc = handle_PipeInitSized((int *) context->regs[1], context->regs[2]);
+      break;
+    case CUSTOM_PIPE_RESIZE:
+      rc = handle_PipeResize(context->regs[1], context->regs[2]);
+      break;
+    default:
+      TracePrintf(1, "Unknown custom syscall %d\n", context->regs[0]);
+      break;
+  }
+  return rc;
+}
+
 /*
  * Handle traps to the kernel
  */
@@ -77,8 +160,16 @@ void handle_trap_kernel(UserContext* context) {
       // do nothing!
       break;
 
-    // TODO -- semaphore stuff?
-
+    // semaphores
+    case YALNIX_SEM_INIT:
+      rc = handle_SemInit((int *)context->regs[0], context->regs[1]);
+      break;
+    case YALNIX_SEM_UP:
+      rc = handle_SemUp(context->regs[0]);
+      break;
+    case YALNIX_SEM_DOWN:
+      rc = handle_SemDown(context->regs[0]);
+      break;
     case YALNIX_LOCK_INIT:
       rc = handle_LockInit((int *)context->regs[0]);
       break;
@@ -114,6 +205,20 @@ void handle_trap_kernel(UserContext* context) {
       else if (id >= min_possible_cvar_id && id <= max_possible_cvar_id) {
         rc = handle_CvarKill(id, 1);
       }
+      else if (id >= min_possible_sem_id && id <= max_possible_sem_id) {
+        rc = handle_SemKill(id, 1);
+      }
+      else if (id >= min_possible_rwlock_id && id <= max_possible_rwlock_id) {
+        rc = handle_RwLockKill(id, 1);
+      }
+      else if (id >= min_possible_barrier_id && id <= max_possible_barrier_id) {
+        rc = handle_BarrierKill(id, 1);
+      }
+      break;
+
+    // our own syscalls
+    case YALNIX_CUSTOM_0:
+      rc = handle_trap_custom(context);
       break;
 
     // TODO -- YALNIX_ABORT
@@ -123,80 +228,83 @@ void handle_trap_kernel(UserContext* context) {
 
 }
 
+/*
+ * Monotonic host time in nanoseconds, for the clock stats
+ */
+static long long clock_now_ns() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (long long) ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/*
+ * Adds a finished clock trap to the clock stats
+ */
+static void record_clock_trap(long long start_ns, bool idle_tick) {
+  long long elapsed_ns = clock_now_ns() - start_ns;
+  if (idle_tick) {
+    clock_stats.num_idle_ticks++;
+    clock_stats.idle_ns += elapsed_ns;
+  }
+  else {
+    clock_stats.num_busy_ticks++;
+    clock_stats.busy_ns += elapsed_ns;
+  }
+  if (clock_stats.num_ticks % CLOCK_STATS_INTERVAL == 0) {
+    print_clock_stats(3);
+  }
+}
+
 /*
  * Handle traps to clock -- starts the next process in the ready queue
  */
 void handle_trap_clock(UserContext* context) {
-  TracePrintf(1, "TRAP_CLOCK: Our kernel hit the clock trap\n");
+  long long start_ns = clock_now_ns();
+  clock_stats.num_ticks++;
 
-  if (ready_queue == NULL) {
+  if (scheduler_global == NULL) {
     TracePrintf(1, "TRAP_CLOCK/DELAY: NULL READY QUEUE\n");
     return;
   }
 
-  // handle Delay:
-  if (delayed_processes != NULL) {
-    if (delayed_processes->prev_pcb == NULL) {
-      TracePrintf(3, "TRAP_CLOCK/DELAY: NULL prev_pcb\n");
-    }
+  // handle Delay: wake up the processes whose timers expire on this tick
+  int num_woken = advance_timer_wheel(timer_wheel_global);
+  bool idle_tick = is_idle && num_woken == 0 && !has_ready(scheduler_global);
 
-    if (delayed_processes->next_pcb == NULL) {
-      TracePrintf(3, "TRAP_CLOCK/DELAY: NULL next_pcb\n");
-    } else {
-      TracePrintf(3, "TRAP_CLOCK/DELAY: Going from %d to %d\n", delayed_processes, delayed_processes->next_pcb);
-    }
+  // charge the running process for the tick; under MLFQ it keeps the CPU until its quantum is up
+  bool quantum_expired = scheduler_tick(scheduler_global, is_idle ? NULL : running_process);
 
-    // go through all processes in the delay data structure
-    pcb_t* next_process = delayed_processes;
-    pcb_t *stored_process = NULL;
-    TracePrintf(1, "TRAP_CLOCK/DELAY: Remaining Ticks: %d\n\n", next_process->delayed_clock_cycles);
-    while (next_process != NULL) {
-      // Because add_to_queue adjust the processes next and previous pointers, we need to save them
-      stored_process = next_process->next_pcb;
-      // decrement their delays
-      next_process->delayed_clock_cycles--;
-      TracePrintf(1, "TRAP_CLOCK/DELAY: Delayed process with id %d now has %d clock cycles remaining\n",
-                  next_process->pid, next_process->delayed_clock_cycles);
-
-      // if any process gets a delay of 0 or less, put it back into the ready queue
-      if (next_process->delayed_clock_cycles <= 0) {
-        TracePrintf(1, "Delayed process with id %d will be put in the ready queue\n", next_process->pid);
-
-        // remove it from the delay data structure
-        if (next_process->prev_pcb == NULL) {
-         TracePrintf(1, "PrevPCB is NULL\n");
-          // next_pcb may be NULL, this is OK
-          if (next_process->next_pcb != NULL) {
-            delayed_processes = next_process->next_pcb;
-            delayed_processes->prev_pcb = NULL;
-          }
-          else {
-            add_to_queue(ready_queue, next_process);
-            delayed_processes = NULL;
-            break;
-          }
-        }
-        else {
-        //  TracePrintf(1, "PrevPCB is NOT NULL\n");
-          // muck with pointers to remove our process from the queue
-          next_process->prev_pcb->next_pcb = next_process->next_pcb;
-          if (next_process->next_pcb != NULL) {
-            next_process->next_pcb->prev_pcb = next_process->prev_pcb;
-          }
-        }
-        add_to_queue(ready_queue, next_process);
-      }
-
-//      TracePrintf(1, "Going from %d to %d\n", next_process, next_process->next_pcb);
-      next_process = stored_process;
-    }
+  // tickless idle: idle would only be switched out for itself, so leave the page tables, TLB and kernel stack be
+  if (idle_tick && tickless_idle) {
+    TracePrintf(5, "TRAP_CLOCK: Tick %u has nothing to run; staying idle\n", timer_wheel_global->now);
+    record_clock_trap(start_ns, true);
+    return;
+  }
+  if (!is_idle && !quantum_expired) {
+    TracePrintf(5, "TRAP_CLOCK: Process %d has %d ticks of its quantum used; it keeps running\n",
+                running_process->pid, running_process->ticks_used);
+    record_clock_trap(start_ns, false);
+    return;
   }
 
-  TracePrintf(3, "TRAP_CLOCK/DELAY: LEFT THE WHILE LOOP, %d\n", delayed_processes);
+  TracePrintf(1, "TRAP_CLOCK: Our kernel hit the clock trap\n");
+  TracePrintf(3, "TRAP_CLOCK/DELAY: Tick %u woke %d processes, %d still delayed\n",
+              timer_wheel_global->now, num_woken, timer_wheel_global->num_armed);
+
   pcb_t* old_process = running_process;
+  clock_switch_pending = true;
+  clock_switch_start_ns = start_ns;
+  clock_switch_tick = timer_wheel_global->now;
+  clock_switch_idle = idle_tick;
 
   // get the next process from the queue
   install_next_from_queue(old_process, 0);
+
+  // we were preempted by a clock trap and have just been switched back to: if that was this tick's trap, time it
+  if (clock_switch_pending && clock_switch_tick == timer_wheel_global->now) {
+    clock_switch_pending = false;
+    record_clock_trap(clock_switch_start_ns, clock_switch_idle);
+  }
 }
 
 /*
@@ -228,6 +336,30 @@ void handle_trap_illegal(UserContext* context) {
 void handle_trap_memory(UserContext* context) {
   TracePrintf(1, "TRAP_MEMORY: Attempting to handle a segfault in user space!\n");
 
+  // a write to a page shared copy-on-write: copy just this page and let the process retry the write.
+  // COW pages are mapped readable, so an access error on one that isn't writable can only be the write;
+  // anything else (e.g. an unmapped address) falls through to the handling below
+  int fault_page = ((int)(context->addr) - VMEM_1_BASE) >> PAGESHIFT;
+  if (context->code == YALNIX_ACCERR && is_cow_page(running_process, fault_page) &&
+      !(running_process->region_1_page_table[fault_page].prot & PROT_WRITE)) {
+    TracePrintf(1, "TRAP_MEMORY: Write to copy-on-write page %d; copying it\n", fault_page);
+    if (break_cow_page(running_process, fault_page) == ERROR) {
+      TracePrintf(1, "TRAP_MEMORY: No free frames to copy a copy-on-write page!\n");
+      delete_process(running_process, ERROR, true);
+    }
+    return;
+  }
+
+  // first touch of a page we haven't loaded from the executable yet: read it in and let the process retry
+  if (is_file_backed_page(running_process, fault_page)) {
+    TracePrintf(1, "TRAP_MEMORY: Loading page %d from the executable\n", fault_page);
+    if (page_in(running_process, fault_page) == ERROR) {
+      TracePrintf(1, "TRAP_MEMORY: Unable to load page %d from the executable!\n", fault_page);
+      delete_process(running_process, ERROR, true);
+    }
+    return;
+  }
+
   // what is the lowest page in the stack?
   int stack_page_id = (UP_TO_PAGE(VMEM_1_SIZE) >> PAGESHIFT) - 1;
   // keep running down the page table until we hit an invalid page
@@ -252,7 +384,7 @@ void handle_trap_memory(UserContext* context) {
     // allocates new stack pages
     int iteration_start = 0;
     while (page < stack_page_id) {
-      iteration_start = get_free_frame(frame_table_global->frame_table, frame_table_global->frame_table_size, iteration_start);
+      iteration_start = get_free_frame_or_evict(running_process->pid);
 
       if (iteration_start == MEMFULL) {
         TracePrintf(1, "TRAP_MEMORY: No free frames to handle segfault!\n");
@@ -331,6 +463,6 @@ void handle_trap_tty_transmit(UserContext* context) {
   }
   TracePrintf(1, "TRAP_TTY_TRANSMIT: tty_id = %d\n", tty_id);
   // wake up the waiting process
-  add_to_queue(ready_queue, tty->writing_proc);
+  add_ready(scheduler_global, tty->writing_proc);
 }
 
@@ -22,7 +22,7 @@ extern frame_table_struct_t *frame_table_global;
 extern pcb_t* running_process;
 extern pcb_t* idle_process;
 extern bool is_idle;
-extern queue_t* ready_queue;
+extern scheduler_t *scheduler_global;
 extern void *trap_handler[16];
 extern pte_t *region_0_page_table;
 extern tty_object_t *tty_objects[NUM_TERMINALS];
@@ -31,6 +31,24 @@ extern char tty_buffer[TTY_BUFFER_SIZE];
 
 // typedef void (*trap_handler_t) (UserContext* context);
 
+#define CLOCK_STATS_INTERVAL 100                       // trace the clock stats every this many ticks
+
+/*
+* Clock trap accounting, so the cost of a tick (and what tickless idle saves) can be measured.
+* An idle tick is one where idle was running and still has nothing to switch to. A tick's time runs from
+* the trap until the next process resumes; ticks whose next process resumes outside the clock handler
+* (e.g. in Delay) aren't timed.
+*/
+typedef struct clock_stats {
+  int num_ticks;                                       // clock traps taken
+  int num_idle_ticks;                                  // timed idle ticks
+  long long idle_ns;                                   // time spent in them
+  int num_busy_ticks;                                  // timed ticks that woke or switched to a real process
+  long long busy_ns;                                   // time spent in them
+} clock_stats_t;
+
+extern clock_stats_t clock_stats;
+
 /*
  * Handle traps to the kernel
  */